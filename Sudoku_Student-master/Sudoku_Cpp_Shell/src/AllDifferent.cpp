@@ -0,0 +1,225 @@
+#include "AllDifferent.hpp"
+
+#include <algorithm>
+
+/**
+ * Generalized arc consistency for all-different units (Régin). Every
+ * unit is assumed to hold exactly as many cells as there are values,
+ * so a complete matching leaves no free value and the strongly
+ * connected components alone decide which edges survive.
+ */
+
+typedef Domain::Word Word;
+
+// Returns true if value is set in a cell mask
+static bool holds ( const Word* bits, int value )
+{
+	int bit = value - 1;
+	return ( bits[bit / Domain::WORD_BITS] >> ( bit % Domain::WORD_BITS ) ) & 1;
+}
+
+// =====================================================================
+// Constructors
+// =====================================================================
+
+AllDifferent::AllDifferent ( void )
+{
+
+}
+
+AllDifferent::AllDifferent ( int units, int values )
+{
+	numUnits = units;
+	numValues = values;
+
+	cellOfValue.assign( (std::size_t)units * values, -1 );
+	valueOfCell.assign( (std::size_t)units * values, 0 );
+	visited.assign( values, 0 );
+
+	index.assign( values, -1 );
+	lowLink.assign( values, 0 );
+	component.assign( values, 0 );
+	onStack.assign( values, 0 );
+	stack.reserve( values );
+
+	queue.reserve( units );
+	queued.assign( units, 0 );
+}
+
+// =====================================================================
+// Propagation
+// =====================================================================
+
+bool AllDifferent::propagate ( ConstraintNetwork& network, Trail* trail, const std::vector< int >& units )
+{
+	for ( int unit : units )
+		enqueue( unit );
+
+	bool consistent = true;
+	for ( std::size_t head = 0; head < queue.size(); ++head )
+	{
+		int unit = queue[head];
+		queued[unit] = 0;
+
+		if ( consistent && ! enforce( network, trail, unit ) )
+			consistent = false;
+	}
+
+	queue.clear();
+	return consistent;
+}
+
+long AllDifferent::getRemovalCount ( void ) const
+{
+	return numRemovals;
+}
+
+void AllDifferent::enqueue ( int unit )
+{
+	if ( ! queued[unit] )
+	{
+		queued[unit] = 1;
+		queue.push_back( unit );
+	}
+}
+
+// Repairs the unit's matching, then removes every value that lies in no
+// complete matching
+bool AllDifferent::enforce ( ConstraintNetwork& network, Trail* trail, int unit )
+{
+	const NetworkState& state = network.getState();
+	const ConstraintNetwork::ConstraintSet& constraints = network.getConstraints();
+	const Constraint& c = constraints[unit];
+	int n = c.vars.size();
+	int* cellOf  = cellOfValue.data() + (std::size_t)unit * numValues;
+	int* valueOf = valueOfCell.data() + (std::size_t)unit * numValues;
+
+	// Drop matched edges whose value has left the cell since last time
+	for ( int pos = 0; pos < n; ++pos )
+	{
+		int value = valueOf[pos];
+		if ( value != 0 && ! holds( state.mask( c.vars[pos]->index() ), value ) )
+		{
+			cellOf[value - 1] = -1;
+			valueOf[pos] = 0;
+		}
+	}
+
+	for ( int pos = 0; pos < n; ++pos )
+	{
+		if ( valueOf[pos] != 0 )
+			continue;
+
+		++visitStamp;
+		if ( ! augment( state, c, unit, pos ) )
+			return false;
+	}
+
+	// Residual graph: cell -> the cell matched to each of its other values
+	std::fill( index.begin(), index.begin() + n, -1 );
+	nextIndex = 0;
+	numComponents = 0;
+	for ( int pos = 0; pos < n; ++pos )
+		if ( index[pos] == -1 )
+			strongConnect( state, c, unit, pos );
+
+	for ( int pos = 0; pos < n; ++pos )
+	{
+		Variable* var = c.vars[pos];
+		Domain values( state.mask( var->index() ) );
+
+		for ( int value : values )
+		{
+			if ( value == valueOf[pos] || component[pos] == component[cellOf[value - 1]] )
+				continue;
+
+			trail->push( var );
+			var->removeValueFromDomain( value );
+			numRemovals++;
+
+			for ( Constraint* other : network.getConstraintsContainingVariable( var ) )
+				if ( other != &c )
+					enqueue( other - constraints.data() );
+		}
+	}
+
+	return true;
+}
+
+// Finds an augmenting path from the free cell at pos
+bool AllDifferent::augment ( const NetworkState& state, const Constraint& c, int unit, int pos )
+{
+	int* cellOf  = cellOfValue.data() + (std::size_t)unit * numValues;
+	int* valueOf = valueOfCell.data() + (std::size_t)unit * numValues;
+	Domain values( state.mask( c.vars[pos]->index() ) );
+
+	// A free value ends the path at once
+	for ( int value : values )
+	{
+		if ( value <= numValues && cellOf[value - 1] == -1 )
+		{
+			cellOf[value - 1] = pos;
+			valueOf[pos] = value;
+			return true;
+		}
+	}
+
+	for ( int value : values )
+	{
+		if ( value > numValues || visited[value - 1] == visitStamp )
+			continue;
+
+		visited[value - 1] = visitStamp;
+		if ( augment( state, c, unit, cellOf[value - 1] ) )
+		{
+			cellOf[value - 1] = pos;
+			valueOf[pos] = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Tarjan's algorithm from the cell at pos
+void AllDifferent::strongConnect ( const NetworkState& state, const Constraint& c, int unit, int pos )
+{
+	const int* cellOf  = cellOfValue.data() + (std::size_t)unit * numValues;
+	const int* valueOf = valueOfCell.data() + (std::size_t)unit * numValues;
+
+	index[pos] = lowLink[pos] = nextIndex++;
+	stack.push_back( pos );
+	onStack[pos] = 1;
+
+	Domain values( state.mask( c.vars[pos]->index() ) );
+	for ( int value : values )
+	{
+		if ( value == valueOf[pos] )
+			continue;
+
+		int next = cellOf[value - 1];
+		if ( index[next] == -1 )
+		{
+			strongConnect( state, c, unit, next );
+			lowLink[pos] = std::min( lowLink[pos], lowLink[next] );
+		}
+		else if ( onStack[next] )
+		{
+			lowLink[pos] = std::min( lowLink[pos], index[next] );
+		}
+	}
+
+	if ( lowLink[pos] != index[pos] )
+		return;
+
+	int member;
+	do
+	{
+		member = stack.back();
+		stack.pop_back();
+		onStack[member] = 0;
+		component[member] = numComponents;
+	}
+	while ( member != pos );
+	numComponents++;
+}
@@ -0,0 +1,71 @@
+#ifndef ALLDIFFERENT_HPP
+#define ALLDIFFERENT_HPP
+
+#include "ConstraintNetwork.hpp"
+#include "Trail.hpp"
+
+#include <vector>
+
+/**
+ * Generalized arc consistency for the all-different units of a
+ * network (Régin's algorithm).
+ *
+ * Each unit keeps a maximum matching between its cells and values. A
+ * value survives in a cell only if the edge is in the matching, or cell
+ * and value share a strongly connected component of the residual graph;
+ * every other value is removed through the trail.
+ *
+ * Matchings are kept between calls. Backtracking only grows domains, so
+ * a matching stays valid after an undo, and each call just drops the
+ * edges whose value has since left the cell and repairs them with
+ * augmenting paths.
+ */
+
+class AllDifferent
+{
+public:
+	// Constructors
+	AllDifferent ( void );
+	AllDifferent ( int units, int values );
+
+	// Makes every unit in units, and every unit touched by a removal,
+	// GAC. Returns false if some unit has no complete matching.
+	bool propagate ( ConstraintNetwork& network, Trail* trail, const std::vector< int >& units );
+
+	long getRemovalCount ( void ) const;
+
+private:
+	bool enforce ( ConstraintNetwork& network, Trail* trail, int unit );
+	bool augment ( const NetworkState& state, const Constraint& c, int unit, int pos );
+	void strongConnect ( const NetworkState& state, const Constraint& c, int unit, int pos );
+	void enqueue ( int unit );
+
+	int numUnits = 0;
+	int numValues = 0;
+	long numRemovals = 0;
+
+	// Matching, keyed unit * numValues: value - 1 -> cell position, and
+	// cell position -> value (0 when free)
+	std::vector< int > cellOfValue;
+	std::vector< int > valueOfCell;
+
+	// Augmenting path search: value visited in pass visitStamp
+	std::vector< int > visited;
+	int visitStamp = 0;
+
+	// Tarjan SCC over the cells of one unit (values fold into the cell
+	// they are matched to)
+	std::vector< int > index;
+	std::vector< int > lowLink;
+	std::vector< int > component;
+	std::vector< int > stack;
+	std::vector< char > onStack;
+	int nextIndex = 0;
+	int numComponents = 0;
+
+	// Units waiting to be made GAC
+	std::vector< int > queue;
+	std::vector< char > queued;
+};
+
+#endif
@@ -2,12 +2,16 @@
 
 using namespace std;
 
+const float BTSolver::DEFAULT_TIME = 600.0;
+
 // =====================================================================
 // Constructors
 // =====================================================================
 
 BTSolver::BTSolver ( SudokuBoard input, Trail* _trail,  string val_sh, string var_sh, string cc )
-: sudokuGrid( input.get_p(), input.get_q(), input.get_board() ), network( input )
+: sudokuGrid( input.get_p(), input.get_q(), input.get_board() ), network( input ),
+  kernel( input.get_p(), input.get_q() ),
+  gac( network.getConstraints().size(), input.get_n() )
 {
 	valHeuristics = val_sh;
 	varHeuristics = var_sh;
@@ -23,7 +27,7 @@ BTSolver::BTSolver ( SudokuBoard input, Trail* _trail,  string val_sh, string va
 // Basic consistency check, no propagation done
 bool BTSolver::assignmentsCheck ( void )
 {
-	for ( Constraint c : network.getConstraints() )
+	for ( const Constraint& c : network.getConstraints() )
 		if ( ! c.isConsistent() )
 			return false;
 
@@ -36,19 +40,19 @@ bool BTSolver::assignmentsCheck ( void )
 bool BTSolver::arcConsistency ( void )
 {
     vector<Variable*> toAssign;
-    vector<Constraint*> RMC = network.getModifiedConstraints();
+    const vector<Constraint*>& RMC = network.getModifiedConstraints();
     for (int i = 0; i < RMC.size(); ++i)
     {
-        vector<Variable*> LV = RMC[i]->vars;
+        const vector<Variable*>& LV = RMC[i]->vars;
         for (int j = 0; j < LV.size(); ++j)
         {
             if(LV[j]->isAssigned())
             {
-                vector<Variable*> Neighbors = network.getNeighborsOfVariable(LV[j]);
+                ConstraintNetwork::VariableSlice Neighbors = network.getNeighborsOfVariable(LV[j]);
                 int assignedValue = LV[j]->getAssignment();
                 for (int k = 0; k < Neighbors.size(); ++k)
                 {
-                    Domain D = Neighbors[k]->getDomain();
+                    const Domain D = Neighbors[k]->getDomain();
                     if(D.contains(assignedValue))
                     {
                         if (D.size() == 1)
@@ -66,10 +70,9 @@ bool BTSolver::arcConsistency ( void )
     {
         for (int i = 0; i < toAssign.size(); ++i)
         {
-            Domain D = toAssign[i]->getDomain();
-            vector<int> assign = D.getValues();
+            const Domain D = toAssign[i]->getDomain();
             trail->push(toAssign[i]);
-            toAssign[i]->assignValue(assign[0]);
+            toAssign[i]->assignValue(*D.begin());
         }
         return arcConsistency();
     }
@@ -91,34 +94,77 @@ bool BTSolver::arcConsistency ( void )
  */
 pair<map<Variable*,Domain>,bool> BTSolver::forwardChecking ( void )
 {
-	ConstraintNetwork::VariableSet vars = getNetwork().getVariables();
-	bool flag = true;
 	map<Variable*, Domain> ans;
 
+	// One bulk pass computes every open cell's domain minus the values
+	// placed in its row, column and block
+	if(!kernel.run(network.getState()))
+		return make_pair(ans, false);
+
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
 	for(auto var = vars.begin(); var != vars.end(); var++)
 	{
-		if(!(*var)->isAssigned()) continue;
+		if((*var)->isAssigned()) continue;
+
+		Domain reduced(kernel.candidates((*var)->index()));
+		if(reduced.equals((*var)->getDomain())) continue;
+
+		trail->push(*var);
+		(*var)->setDomain(reduced);
+		ans.insert(std::make_pair((*var),reduced));
+	}
+
+	return make_pair(ans, true);
+}
+
+/**
+ * Forward checking driven by the cells fixed since the last call.
+ *
+ * Instead of rescanning every assigned variable, only the queued cells
+ * (the latest decision, plus any neighbour it shrinks to a single value)
+ * eliminate their value from their neighbours, each exactly once.
+ *
+ * Return: same contract as forwardChecking.
+ */
+pair<map<Variable*,Domain>,bool> BTSolver::incrementalForwardChecking ( void )
+{
+	if ( ! queueSeeded )
+	{
+		for ( Variable* v : network.getVariables() )
+			if ( v->isAssigned() )
+				propagationQueue.push_back( v );
+		queueSeeded = true;
+	}
+
+	bool flag = true;
+	map<Variable*, Domain> ans;
+
+	for ( size_t head = 0; head < propagationQueue.size() && flag; ++head )
+	{
+		Variable* var = propagationQueue[head];
+		if ( var->size() != 1 )
+			continue;
+
+		int value = *var->begin();
 
-		ConstraintNetwork::VariableSet nbrs = getNetwork().getNeighborsOfVariable(*var);
-		for(auto nbr = nbrs.begin(); nbr != nbrs.end(); nbr++)
+		for ( Variable* nbr : network.getNeighborsOfVariable( var ) )
 		{
-			Domain::ValueSet nbrdomain = (*nbr)->getValues();
-			if(find(nbrdomain.begin(),nbrdomain.end(),(*var)->getAssignment()) != nbrdomain.end())
-			{
-				trail->push(*nbr);
-				(*nbr)->removeValueFromDomain((*var)->getAssignment());
-				Domain tempdomain((*nbr)->getDomain());
-				ans.erase(*nbr);
-				ans.insert(std::make_pair((*nbr),tempdomain));
-				if((*nbr)->size() == 0){
-					flag = false;
-				}
-			}
-				
+			if ( ! nbr->getDomain().contains( value ) )
+				continue;
+
+			trail->push( nbr );
+			nbr->removeValueFromDomain( value );
+			ans[nbr] = nbr->getDomain();
+
+			if ( nbr->size() == 0 )
+				flag = false;
+			else if ( nbr->size() == 1 )
+				propagationQueue.push_back( nbr );
 		}
 	}
 
-	return make_pair(ans, flag);
+	propagationQueue.clear();
+	return make_pair( ans, flag );
 }
 
 /**
@@ -142,105 +188,271 @@ pair<map<Variable*,int>,bool> BTSolver::norvigCheck ( void )
 {
 	pair<map<Variable*,int>, bool> ans;
 	ans.second = forwardChecking().second;
-	vector<Constraint*> modConstraints = network.getModifiedConstraints();
-	int N = sudokuGrid.get_q()*sudokuGrid.get_p();
-	
-	for(int i=0; i<modConstraints.size(); i++) {
-		vector<Variable*> variables_ = modConstraints[i]->vars;
-		for(int j=0; j<variables_.size(); j++) {
-			int row = variables_[j]->row(); int col = variables_[j]->col(); int block = variables_[j]->block();
-			vector<Variable*> varNeighbors = network.getNeighborsOfVariable(variables_[j]);
-			varNeighbors.push_back(variables_[j]);
-			int count[N+1]; 
-
-			for(int a=0; a<=N; a++) {
-				count[a] = 0;
-			}
 
-			for(int k=0; k<varNeighbors.size(); k++) {
-				if(varNeighbors[k]->row() == row) {
-					vector<int> v = varNeighbors[k]->getDomain().getValues();
-					for(int l=0; l<v.size(); l++) {
-						count[v[l]]++;
-					}
-				}
-			}
+	// (2) only needs to look at the (unit, value) pairs whose support
+	// just dropped to one place, or to none
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+	int unit, value;
 
-			for(int k=1; k<=N; k++) {
-				if(count[k] == 1) {
-					for(int m=0; m<varNeighbors.size(); m++) {
-						if(!varNeighbors[m]->isAssigned() &&  varNeighbors[m]->row() == row) {
-							if(varNeighbors[m]->getDomain().contains(k)) {
-								trail->push(varNeighbors[m]);
-								varNeighbors[m]->assignValue(k);
-								ans.first[varNeighbors[m]] = k;
-								ans.second = forwardChecking().second;
-							}
-						}
-					}
-				}
-			}
-			
-			for(int a=0; a<=N; a++) {
-				count[a] = 0;
-			}
+	while ( ans.second && state.nextSupportEvent( unit, value ) )
+	{
+		int count = state.supportCount( unit, value );
 
-			for(int k=0; k<varNeighbors.size(); k++) {
-				if(varNeighbors[k]->col() == col) {
-					vector<int> v = varNeighbors[k]->getDomain().getValues();
-					for(int m=0; m<v.size(); m++) {
-						count[v[m]]++;
-					}
-				}
-			}
+		if ( count == 0 )
+		{
+			ans.second = false;
+			break;
+		}
 
-			for(int k=1;k<=N;k++) {
-				if(count[k] == 1) {
-					for(int m=0; m<varNeighbors.size(); m++) {
-						if(!varNeighbors[m]->isAssigned() && varNeighbors[m]->col() == col) {
-							if(varNeighbors[m]->getDomain().contains(k)) {
-								trail->push(varNeighbors[m]);
-								varNeighbors[m]->assignValue(k);
-								ans.first[varNeighbors[m]] = k;
-								ans.second = forwardChecking().second;
-							}
-						}
-					}
-				}
-			} 
+		if ( count != 1 )
+			continue;
 
-			for(int a=0; a<=N; a++) {
-				count[a] = 0;
-			}
+		Variable* var = vars[state.locate( unit, value )];
 
-			for(int k=0; k<varNeighbors.size(); k++) {
-				if(varNeighbors[k]->block() == block) {
-					vector<int> v = varNeighbors[k]->getDomain().getValues();
-					for(int m=0;m<v.size();m++) {
-						count[v[m]]++;
-					}
-				}
+		if ( var->isAssigned() )
+			continue;
+
+		trail->push(var);
+		var->assignValue(value);
+		ans.first[var] = value;
+		ans.second = forwardChecking().second;
+	}
+
+	return ans;
+}
+
+/**
+ * Locked candidates, read off the per-value bitboards.
+ *
+ * Pointing: if every cell of a block that can take a value lies in one
+ * row (or column), the value is removed from the rest of that line.
+ * Box/line: if every cell of a row or column that can take a value lies
+ * in one block, the value is removed from the rest of that block.
+ *
+ * Both are the same rule for any two units that meet, so the covering
+ * units come from the network's unit index. Where a block repeats a row
+ * or column (p or q of 1) the network holds no separate block unit, and
+ * the rule simply finds nothing to remove.
+ *
+ * Return: false if a removal left a domain empty (or hit a placed value).
+ */
+bool BTSolver::lockedCandidates ( void )
+{
+	int units = network.getConstraints().size();
+	int N = sudokuGrid.get_n();
+
+	// Every block repeats a row or a column, so nothing can be locked
+	if ( sudokuGrid.get_p() == 1 || sudokuGrid.get_q() == 1 )
+		return true;
+
+	for ( int unit = 0; unit < units; ++unit )
+		for ( int value = 1; value <= N; ++value )
+			if ( ! lockCandidates( unit, value ) )
+				return false;
+
+	return true;
+}
+
+// Applies locked candidates to one (unit, value) pair
+bool BTSolver::lockCandidates ( int unit, int value )
+{
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+	const Word* digit = state.digitBoard( value );
+	const Word* cells = state.unitBoard( unit );
+	int words = state.boardWords();
+
+	int count = 0;
+	for ( int w = 0; w < words; ++w )
+		count += __builtin_popcountll( digit[w] & cells[w] );
+
+	if ( count < 2 )
+		return true;
+
+	// Candidate covering units: the other units of the first place
+	int first = state.locate( unit, value );
+	const int* covers = state.cellUnits( first );
+	int numCovers = state.cellUnitCount( first );
+
+	for ( int k = 0; k < numCovers; ++k )
+	{
+		if ( covers[k] == unit )
+			continue;
+
+		const Word* cover = state.unitBoard( covers[k] );
+
+		bool locked = true;
+		for ( int w = 0; w < words && locked; ++w )
+			locked = ( digit[w] & cells[w] & ~cover[w] ) == 0;
+
+		if ( ! locked )
+			continue;
+
+		for ( int w = 0; w < words; ++w )
+		{
+			for ( Word rest = digit[w] & cover[w] & ~cells[w]; rest; rest &= rest - 1 )
+			{
+				Variable* var = vars[w * Domain::WORD_BITS + __builtin_ctzll( rest )];
+				if ( var->isAssigned() || ! eliminate( var, value ) )
+					return false;
 			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Generalized arc consistency on every all-different unit (Régin).
+ *
+ * Only units holding a cell modified since the last call are
+ * re-checked, plus whatever units the propagator's own removals touch.
+ * This subsumes forward checking and prunes every Hall set.
+ *
+ * Return: true if every unit still has a complete matching.
+ */
+bool BTSolver::generalizedArcConsistency ( void )
+{
+	const ConstraintNetwork::ConstraintSet& units = network.getConstraints();
+	const ConstraintNetwork::ConstraintRefSet& modified = network.getModifiedConstraints();
+
+	gacUnits.clear();
+	if ( ! gacSeeded )
+	{
+		for ( int u = 0; u < (int)units.size(); ++u )
+			gacUnits.push_back( u );
+		gacSeeded = true;
+	}
+	else
+	{
+		for ( Constraint* c : modified )
+			gacUnits.push_back( c - units.data() );
+	}
+
+	if ( ! gac.propagate( network, trail, gacUnits ) )
+		return false;
 
-			for(int k=1; k<=N; k++) {
-				if(count[k] == 1) {
-					for(int m=0; m<varNeighbors.size(); m++) {
-						if(!varNeighbors[m]->isAssigned() && varNeighbors[m]->block() == block) {
-							if(varNeighbors[m]->getDomain().contains(k)) {
-								trail->push(varNeighbors[m]);
-								varNeighbors[m]->assignValue(k);
-								ans.first[varNeighbors[m]] = k;
-								ans.second = forwardChecking().second;
-							}
-						}
-					}
+	// The network is at a fixpoint, so the propagator's own changes
+	// need no second look
+	network.getModifiedConstraints();
+	return true;
+}
+
+// =====================================================================
+// Fish
+// =====================================================================
+
+void BTSolver::setFishSize ( int size )
+{
+	fishSize = std::max( 0, std::min( size, 4 ) );
+}
+
+/**
+ * Basic fish (X-Wing, Swordfish, Jellyfish) for every value, with rows
+ * and then columns as base lines.
+ *
+ * If k base lines can only take a value within the same k cross lines,
+ * the value is removed from the rest of those cross lines. Fewer than k
+ * cross lines is a contradiction.
+ *
+ * Each line's candidates are a mask of cross lines, so the search only
+ * ORs and popcounts masks. Boards with N > 64 are skipped.
+ *
+ * Return: false on a contradiction.
+ */
+bool BTSolver::fish ( void )
+{
+	int N = sudokuGrid.get_n();
+	if ( N > Domain::WORD_BITS )
+		return true;
+
+	for ( int value = 1; value <= N; ++value )
+		if ( ! fishDigit( value, true ) || ! fishDigit( value, false ) )
+			return false;
+
+	return true;
+}
+
+// Builds the line masks for one value and orientation, then searches
+bool BTSolver::fishDigit ( int value, bool byRow )
+{
+	NetworkState& state = network.getState();
+	const Word* digit = state.digitBoard( value );
+	int N = sudokuGrid.get_n();
+
+	fishLines.assign( N, 0 );
+	fishBase.clear();
+
+	for ( int line = 0; line < N; ++line )
+	{
+		bool placed = false;
+		for ( int cross = 0; cross < N && ! placed; ++cross )
+		{
+			int cell = byRow ? line * N + cross : cross * N + line;
+			if ( ! ( ( digit[cell / Domain::WORD_BITS] >> ( cell % Domain::WORD_BITS ) ) & 1 ) )
+				continue;
+
+			if ( state.hasFlag( cell, NetworkState::ASSIGNED ) )
+				placed = true;
+			else
+				fishLines[line] |= Word(1) << cross;
+		}
+
+		int count = __builtin_popcountll( fishLines[line] );
+		if ( ! placed && count >= 2 && count <= fishSize )
+			fishBase.push_back( line );
+	}
+
+	return fishSearch( value, byRow, 0, 0, 0 );
+}
+
+// Extends the current set of base lines; cover is their cross lines
+bool BTSolver::fishSearch ( int value, bool byRow, int next, int depth, Word cover )
+{
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+	int N = sudokuGrid.get_n();
+
+	for ( int i = next; i < (int)fishBase.size(); ++i )
+	{
+		int line = fishBase[i];
+		Word merged = cover | fishLines[line];
+		int size = __builtin_popcountll( merged );
+		int lines = depth + 1;
+
+		if ( size > fishSize )
+			continue;
+		if ( size < lines )
+			return false;
+
+		fishPicked[depth] = line;
+
+		if ( lines >= 2 && size == lines )
+		{
+			for ( int other = 0; other < N; ++other )
+			{
+				bool picked = false;
+				for ( int k = 0; k < lines; ++k )
+					picked = picked || fishPicked[k] == other;
+				if ( picked )
+					continue;
+
+				for ( Word rest = merged & fishLines[other]; rest; rest &= rest - 1 )
+				{
+					int cross = __builtin_ctzll( rest );
+					int cell = byRow ? other * N + cross : cross * N + other;
+					fishLines[other] &= ~( Word(1) << cross );
+					if ( ! eliminate( vars[cell], value ) )
+						return false;
 				}
 			}
-
 		}
+
+		if ( lines < fishSize && ! fishSearch( value, byRow, i + 1, lines, merged ) )
+			return false;
 	}
 
-	return ans;
+	return true;
 }
 
 /**
@@ -248,10 +460,259 @@ pair<map<Variable*,int>,bool> BTSolver::norvigCheck ( void )
  *
  * Completing the three tourn heuristic will automatically enter
  * your program into a tournament.
+ *
+ * Runs the techniques below to a fixpoint, cheapest first. Forward
+ * checking of newly fixed cells runs before every step, and any step
+ * that changes a domain sends the loop back to the first one, so the
+ * expensive subset searches only run once the cheap rules are stuck.
+ * Every change goes through the trail.
+ *
+ * Return: true if the network is still consistent.
  */
 bool BTSolver::getTournCC ( void )
 {
-	return false;
+	const int steps = 7;
+	bool consistent = true;
+	int step = 0;
+
+	while ( consistent && step < steps )
+	{
+		long before = progress;
+		consistent = incrementalForwardChecking().second && tournStep( step );
+		step = progress == before ? step + 1 : 0;
+	}
+
+	return consistent;
+}
+
+bool BTSolver::tournStep ( int step )
+{
+	switch ( step )
+	{
+		case 0: return nakedSingles();
+		case 1: return hiddenSingles();
+		case 2: return lockedCandidates();
+		case 3: return nakedSubsets( 2 );
+		case 4: return hiddenSubsets( 2 );
+		case 5: return nakedSubsets( 3 );
+		case 6: return hiddenSubsets( 3 );
+	}
+	return true;
+}
+
+// Assigns every open cell whose domain is down to one value
+bool BTSolver::nakedSingles ( void )
+{
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+
+	for ( int cell = state.firstMinimumCell(); cell != -1; cell = state.firstMinimumCell() )
+	{
+		int size = state.domainSize( cell );
+		if ( size == 0 )
+			return false;
+		if ( size > 1 )
+			break;
+
+		place( vars[cell], *vars[cell]->begin() );
+	}
+
+	return true;
+}
+
+// Assigns the first value found with one place left in some unit
+bool BTSolver::hiddenSingles ( void )
+{
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+	int unit, value;
+
+	while ( state.nextSupportEvent( unit, value ) )
+	{
+		int count = state.supportCount( unit, value );
+		if ( count == 0 )
+			return false;
+		if ( count != 1 )
+			continue;
+
+		Variable* var = vars[state.locate( unit, value )];
+		if ( var->isAssigned() )
+			continue;
+
+		place( var, value );
+		return true;
+	}
+
+	return true;
+}
+
+// Steps idx (k sorted indices below n) to the next combination
+static bool nextCombination ( int* idx, int k, int n )
+{
+	int i = k - 1;
+	while ( i >= 0 && idx[i] == n - k + i )
+		--i;
+	if ( i < 0 )
+		return false;
+
+	++idx[i];
+	for ( int j = i + 1; j < k; ++j )
+		idx[j] = idx[j-1] + 1;
+	return true;
+}
+
+/**
+ * Naked subsets: if k open cells of a unit share exactly k values
+ * between them, those values are removed from the rest of the unit.
+ * Fewer than k values is a contradiction.
+ */
+bool BTSolver::nakedSubsets ( int k )
+{
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::ConstraintSet& units = network.getConstraints();
+
+	for ( const Constraint& c : units )
+	{
+		subsetCells.clear();
+		for ( Variable* var : c.vars )
+			if ( ! var->isAssigned() && var->size() >= 2 && var->size() <= k )
+				subsetCells.push_back( var );
+
+		int n = subsetCells.size();
+		if ( n < k )
+			continue;
+
+		int idx[3] = { 0, 1, 2 };
+		do
+		{
+			Word values[Domain::WORDS] = {};
+			for ( int i = 0; i < k; ++i )
+			{
+				const Word* bits = state.mask( subsetCells[idx[i]]->index() );
+				for ( int w = 0; w < Domain::WORDS; ++w )
+					values[w] |= bits[w];
+			}
+
+			Domain shared( values );
+			if ( shared.size() < k )
+				return false;
+			if ( shared.size() > k )
+				continue;
+
+			for ( Variable* var : c.vars )
+			{
+				if ( var->isAssigned() )
+					continue;
+
+				bool member = false;
+				for ( int i = 0; i < k; ++i )
+					member = member || subsetCells[idx[i]] == var;
+				if ( member )
+					continue;
+
+				for ( int value : shared )
+					if ( var->getDomain().contains( value ) && ! eliminate( var, value ) )
+						return false;
+			}
+		}
+		while ( nextCombination( idx, k, n ) );
+	}
+
+	return true;
+}
+
+/**
+ * Hidden subsets: if k values of a unit can only go in the same k
+ * cells, every other value is removed from those cells. Fewer than k
+ * cells is a contradiction.
+ */
+bool BTSolver::hiddenSubsets ( int k )
+{
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
+	int units = network.getConstraints().size();
+	int words = state.boardWords();
+	int N = sudokuGrid.get_n();
+
+	subsetBoard.resize( words );
+
+	for ( int unit = 0; unit < units; ++unit )
+	{
+		subsetValues.clear();
+		for ( int value = 1; value <= N; ++value )
+		{
+			int count = state.supportCount( unit, value );
+			if ( count >= 2 && count <= k )
+				subsetValues.push_back( value );
+		}
+
+		int n = subsetValues.size();
+		if ( n < k )
+			continue;
+
+		const Word* cells = state.unitBoard( unit );
+		int idx[3] = { 0, 1, 2 };
+		do
+		{
+			Domain keep;
+			std::fill( subsetBoard.begin(), subsetBoard.end(), 0 );
+			for ( int i = 0; i < k; ++i )
+			{
+				const Word* digit = state.digitBoard( subsetValues[idx[i]] );
+				keep.add( subsetValues[idx[i]] );
+				for ( int w = 0; w < words; ++w )
+					subsetBoard[w] |= digit[w] & cells[w];
+			}
+
+			int places = 0;
+			for ( int w = 0; w < words; ++w )
+				places += __builtin_popcountll( subsetBoard[w] );
+
+			if ( places < k )
+				return false;
+			if ( places > k )
+				continue;
+
+			for ( int w = 0; w < words; ++w )
+			{
+				for ( Word rest = subsetBoard[w]; rest; rest &= rest - 1 )
+				{
+					Variable* var = vars[w * Domain::WORD_BITS + __builtin_ctzll( rest )];
+					if ( var->isAssigned() )
+						continue;
+
+					for ( int value : var->getDomain().getValues() )
+						if ( ! keep.contains( value ) && ! eliminate( var, value ) )
+							return false;
+				}
+			}
+		}
+		while ( nextCombination( idx, k, n ) );
+	}
+
+	return true;
+}
+
+// Removes value from var's domain through the trail, and queues the
+// cell for forward checking once it is down to one value
+bool BTSolver::eliminate ( Variable* var, int value )
+{
+	trail->push( var );
+	var->removeValueFromDomain( value );
+	progress++;
+
+	if ( var->size() == 1 )
+		propagationQueue.push_back( var );
+	return var->size() != 0;
+}
+
+// Assigns value to var through the trail and queues it for forward checking
+void BTSolver::place ( Variable* var, int value )
+{
+	trail->push( var );
+	var->assignValue( value );
+	progress++;
+	propagationQueue.push_back( var );
 }
 
 // =====================================================================
@@ -276,23 +737,14 @@ Variable* BTSolver::getfirstUnassignedVariable ( void )
  */
 Variable* BTSolver::getMRV ( void )
 {
-	//cout<<"Inside MRV\n";
-	ConstraintNetwork::VariableSet vars = getNetwork().getVariables();
-	int minval = 2147483647;
+	// The state's MRV index keeps one bitboard of unassigned cells per
+	// domain size; ties go to the lowest cell, as a row-major scan would
+	int cell = network.getState().firstSmallestCell();
 
-	Variable *ans = NULL;
+	if ( cell < 0 )
+		return nullptr;
 
-	for(auto it = vars.begin(); it != vars.end() ; it++)
-	{
-		if((*it)->size()<minval && !(*it)->isAssigned())
-		{
-			minval = (*it)->size();
-			ans = *it;
-		}
-	}
-	//cout<<"Row:"<<ans->row()<<" "<<"Col:"<<ans->col()<<endl;
-	//cout<<"Finish MRV\n";
-	return ans;
+	return network.getVariables()[cell];
 }
 
 /**
@@ -306,44 +758,18 @@ Variable* BTSolver::getMRV ( void )
  */
 vector<Variable*> BTSolver::MRVwithTieBreaker ( void )
 {
-
-	Variable* ans = getMRV();
+	// The index is keyed by (domain size, unassigned degree), so the
+	// lowest key's board holds exactly the tied variables, in cell order
+	NetworkState& state = network.getState();
+	const ConstraintNetwork::VariableSet& vars = network.getVariables();
 	vector<Variable*> mad;
-	int minSize = ans->size();
-	int degree = 0;
-	vector<Variable*> neighbours = getNetwork().getNeighborsOfVariable(ans);
-	
-	for(auto it = neighbours.begin(); it != neighbours.end(); it++){
-		if(!(*it)->isAssigned()){
-			degree++;
-		}
-	} 
-	
-	vector<Variable*> vars = getNetwork().getVariables();
-	for(auto it = vars.begin(); it != vars.end(); it++){
-
-		if(!(*it)->isAssigned() && (*it)->size() == minSize){
-
-			int count = 0;
-			vector<Variable*> tempNeighbors = getNetwork().getNeighborsOfVariable(*it);
-			
-			for(auto v = tempNeighbors.begin(); v != tempNeighbors.end(); v++){
-				if(!(*v)->isAssigned())
-					count++;
-			}
-			
-			if(count>degree){
-				degree = count;
-				mad.clear();
-			}
-			
-			if(count == degree){
-			mad.push_back(*it);
-			}
-		}
-	}
-return mad;	
+
+	for ( int cell = state.firstMinimumCell(); cell != -1; cell = state.nextInBucket( cell ) )
+		mad.push_back( vars[cell] );
+
+	return mad;
 }
+
 /**
  * Optional TODO: Implement your own advanced Variable Heuristic
  *
@@ -352,7 +778,13 @@ return mad;
  */
 Variable* BTSolver::getTournVar ( void )
 {
-	return nullptr;
+	// Smallest domain, ties to the most unassigned peers
+	int cell = network.getState().firstMinimumCell();
+
+	if ( cell < 0 )
+		return nullptr;
+
+	return network.getVariables()[cell];
 }
 
 // =====================================================================
@@ -386,9 +818,10 @@ bool compare(const pair<int, int> &a, const pair<int, int> &b)
 
 vector<int> BTSolver::getValuesLCVOrder ( Variable* v )
 {
-	ConstraintNetwork::VariableSet neighbors = getNetwork().getNeighborsOfVariable(v);
-	Domain::ValueSet currdomain = v->getValues();
+	ConstraintNetwork::VariableSlice neighbors = network.getNeighborsOfVariable(v);
+	const Domain currdomain = v->getDomain();
 	vector<pair<int,int> > counts;
+	counts.reserve(currdomain.size());
 	for(auto it = currdomain.begin(); it != currdomain.end(); it++)
 	{
 		counts.push_back(make_pair((*it), 0));
@@ -398,8 +831,7 @@ vector<int> BTSolver::getValuesLCVOrder ( Variable* v )
 	{
 		for(auto neighbor = neighbors.begin(); neighbor != neighbors.end(); neighbor++)
 		{
-			Domain::ValueSet currneighbordomain = (*neighbor)->getValues();
-			if(std::find(currneighbordomain.begin(), currneighbordomain.end(),(*currdomval).first) != currneighbordomain.end())
+			if((*neighbor)->getDomain().contains((*currdomval).first))
 			{
 					(*currdomval).second++;
 			}
@@ -409,6 +841,7 @@ vector<int> BTSolver::getValuesLCVOrder ( Variable* v )
 	sort(counts.begin(),counts.end(), compare);
 
 	vector<int> ans;
+	ans.reserve(counts.size());
 	for(auto it = counts.begin(); it != counts.end(); it++)
 	{
 		ans.push_back((*it).first);
@@ -424,19 +857,72 @@ vector<int> BTSolver::getValuesLCVOrder ( Variable* v )
  */
 vector<int> BTSolver::getTournVal ( Variable* v )
 {
-	return vector<int>();
+	return getValuesLCVOrder( v );
 }
 
 // =====================================================================
 // Engine Functions
 // =====================================================================
 
-int BTSolver::solve ( float time_left)
+void BTSolver::setDeadline ( Deadline::Clock::time_point at )
+{
+	deadline.set( at );
+}
+
+void BTSolver::setTimeBudget ( long milliseconds )
+{
+	deadline.budget( milliseconds );
+}
+
+// True if the last search gave up at the deadline, as opposed to
+// running out of values
+bool BTSolver::timedOut ( void )
+{
+	return deadline.expired();
+}
+
+void BTSolver::setCancelFlag ( const std::atomic<bool>* flag )
+{
+	deadline.setCancelFlag( flag );
+}
+
+bool BTSolver::wasCancelled ( void )
+{
+	return deadline.cancelled();
+}
+
+bool BTSolver::initialCheck ( void )
+{
+	bool needed = cChecks == "forwardChecking" or cChecks == "incrementalForwardChecking"
+	    or cChecks == "norvigCheck" or cChecks == "tournCC" or cChecks == "generalizedArcConsistency";
+	return ! needed || checkConsistency();
+}
+
+bool BTSolver::run ( bool iterative )
+{
+	if ( ! initialCheck() )
+		return false;
+
+	if ( iterative )
+		solveIterative();
+	else
+		solve();
+	return true;
+}
+
+int BTSolver::solve ( float time_left )
 {
-	if (time_left <= 60.0)
+	if ( ! deadline.isSet() )
+		setTimeBudget( (long)( time_left * 1000.0 ) );
+
+	return search();
+}
+
+int BTSolver::search ( void )
+{
+	if ( deadline.poll() )
 		return -1;
-	double elapsed_time = 0.0;
-    clock_t begin_clock = clock();
+	numNodes++;
 
 	if ( hasSolution )
 		return 0;
@@ -470,17 +956,12 @@ int BTSolver::solve ( float time_left)
 		// Assign the value
 		v->assignValue( i );
 
+		if ( cChecks == "incrementalForwardChecking" or cChecks == "tournCC" )
+			propagationQueue.push_back( v );
+
 		// Propagate constraints, check consistency, recurse
-		if ( checkConsistency() ) {
-			clock_t end_clock = clock();
-			elapsed_time += (float)(end_clock - begin_clock)/ CLOCKS_PER_SEC;
-			double new_start_time = time_left - elapsed_time;
-			int check_status = solve(new_start_time);
-			if(check_status == -1) {
-			    return -1;
-			}
-			
-		}
+		if ( checkConsistency() && search() == -1 )
+			return -1;
 
 		// If this assignment succeeded, return
 		if ( hasSolution )
@@ -492,17 +973,196 @@ int BTSolver::solve ( float time_left)
 	return 0;
 }
 
+/**
+ * Iterative version of solve(). Each open decision is a frame holding
+ * its variable, its values and a cursor into them, so the search keeps
+ * no state on the call stack. Markers, pushes and undos happen in the
+ * same order as in solve(), so both engines visit the same nodes and
+ * return the same solution.
+ *
+ * The frame and value stacks keep their capacity between calls, and the
+ * default value order is read straight from the domain, so a node only
+ * allocates when a value heuristic does.
+ *
+ * The deadline is handled as in solve().
+ */
+int BTSolver::solveIterative ( float time_left )
+{
+	if ( hasSolution )
+		return 0;
+
+	int cells = network.getVariables().size();
+	frames.clear();
+	frames.reserve( cells + 1 );
+	frameValues.clear();
+	frameValues.reserve( (std::size_t)cells * sudokuGrid.get_n() );
+
+	if ( ! deadline.isSet() )
+		setTimeBudget( (long)( time_left * 1000.0 ) );
+
+	bool descend = true;
+
+	while ( true )
+	{
+		if ( descend )
+		{
+			descend = false;
+
+			if ( deadline.poll() )
+				return -1;
+			numNodes++;
+
+			Variable* v = selectNextVariable();
+			if ( v == nullptr )
+			{
+				if ( isComplete() )
+				{
+					hasSolution = true;
+					return 0;
+				}
+
+				// Dead end: back to the parent's next value
+				if ( frames.empty() )
+					return 0;
+				undoDecision();
+			}
+			else
+			{
+				Frame frame;
+				frame.var = v;
+				frame.first = frameValues.size();
+				appendNextValues( v, frameValues );
+				frame.count = frameValues.size() - frame.first;
+				frame.cursor = 0;
+				frames.push_back( frame );
+			}
+		}
+
+		// A node with no values left hands control back to its parent,
+		// which undoes its own current value
+		if ( ! frames.empty() && frames.back().cursor == frames.back().count )
+		{
+			frameValues.resize( frames.back().first );
+			frames.pop_back();
+			if ( frames.empty() )
+				return 0;
+			undoDecision();
+			continue;
+		}
+		if ( frames.empty() )
+			return 0;
+
+		Frame& top = frames.back();
+		int value = frameValues[top.first + top.cursor++];
+
+		if ( decide( top.var, value ) )
+			descend = true;
+		else
+			undoDecision();
+	}
+}
+
+// Same steps as one value of solve()'s loop
+bool BTSolver::decide ( Variable* v, int value )
+{
+	trail->placeTrailMarker();
+	trail->push( v );
+	v->assignValue( value );
+
+	if ( cChecks == "incrementalForwardChecking" or cChecks == "tournCC" )
+		propagationQueue.push_back( v );
+
+	return checkConsistency();
+}
+
+void BTSolver::undoDecision ( void )
+{
+	trail->undo();
+}
+
+bool BTSolver::isComplete ( void )
+{
+	for ( Variable* var : network.getVariables() )
+		if ( ! var->isAssigned() )
+			return false;
+
+	return true;
+}
+
+std::size_t BTSolver::stateBytes ( void )
+{
+	return network.getState().snapshotBytes();
+}
+
+void BTSolver::saveState ( void* out )
+{
+	network.getState().saveSnapshot( out );
+}
+
+// The loaded state is expected to be a fixpoint of the same check, so
+// nothing is left queued for it
+void BTSolver::loadState ( const void* in )
+{
+	trail->clear();
+	network.getState().loadSnapshot( in );
+	propagationQueue.clear();
+	hasSolution = false;
+}
+
+// Appends v's values in the order getNextValues() would return them
+void BTSolver::appendNextValues ( Variable* v, vector<int>& out )
+{
+	if ( valHeuristics == "LeastConstrainingValue" || valHeuristics == "tournVal" )
+	{
+		vector<int> values = getNextValues( v );
+		out.insert( out.end(), values.begin(), values.end() );
+		return;
+	}
+
+	for ( int value : v->getDomain() )
+		out.push_back( value );
+}
+
 bool BTSolver::checkConsistency ( void )
+{
+	int pushes = trail->getPushCount();
+	bool consistent = runCheck();
+
+	// Fish only runs where the chosen check removed nothing at this node,
+	// and every elimination is handed back to it; once the check makes
+	// progress again, fish waits for the next node
+	while ( consistent && fishSize > 0 && trail->getPushCount() == pushes )
+	{
+		long before = progress;
+		if ( ! fish() )
+			return false;
+		if ( progress == before )
+			break;
+
+		pushes = trail->getPushCount();
+		consistent = runCheck();
+	}
+
+	return consistent;
+}
+
+bool BTSolver::runCheck ( void )
 {
 	if ( cChecks == "forwardChecking" )
 		return forwardChecking().second;
 
+	if ( cChecks == "incrementalForwardChecking" )
+		return incrementalForwardChecking().second;
+
 	if ( cChecks == "norvigCheck" )
 		return norvigCheck().second;
 
 	if ( cChecks == "tournCC" )
 		return getTournCC();
 
+	if ( cChecks == "generalizedArcConsistency" )
+		return generalizedArcConsistency();
+
 	return assignmentsCheck();
 }
 
@@ -512,7 +1172,10 @@ Variable* BTSolver::selectNextVariable ( void )
 		return getMRV();
 
 	if ( varHeuristics == "MRVwithTieBreaker" )
-		return MRVwithTieBreaker()[0];
+	{
+		vector<Variable*> tied = MRVwithTieBreaker();
+		return tied.empty() ? nullptr : tied[0];
+	}
 
 	if ( varHeuristics == "tournVar" )
 		return getTournVar();
@@ -541,7 +1204,18 @@ SudokuBoard BTSolver::getSolution ( void )
 	return network.toSudokuBoard ( sudokuGrid.get_p(), sudokuGrid.get_q() );
 }
 
-ConstraintNetwork BTSolver::getNetwork ( void )
+ConstraintNetwork& BTSolver::getNetwork ( void )
 {
 	return network;
 }
+
+CandidateKernel& BTSolver::getKernel ( void )
+{
+	return kernel;
+}
+
+// Number of search nodes (calls to solve) expanded so far
+long BTSolver::getNodeCount ( void )
+{
+	return numNodes;
+}
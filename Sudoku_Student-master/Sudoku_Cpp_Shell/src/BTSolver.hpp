@@ -6,6 +6,9 @@
 #include "Variable.hpp"
 #include "ConstraintNetwork.hpp"
 #include "Trail.hpp"
+#include "CandidateKernel.hpp"
+#include "AllDifferent.hpp"
+#include "Deadline.hpp"
 
 #include <utility>
 #include <iostream>
@@ -21,8 +24,11 @@ public:
 	// Consistency Checks (Implement these)
 	bool assignmentsCheck ( void );
     std::pair<std::map<Variable*,Domain>,bool> forwardChecking  ( void );
+    std::pair<std::map<Variable*,Domain>,bool> incrementalForwardChecking ( void );
     bool arcConsistency ( void );
     std::pair<std::map<Variable*,int>,bool> norvigCheck      ( void );
+	bool lockedCandidates ( void );
+	bool generalizedArcConsistency ( void );
 	bool getTournCC       ( void );
 
 	// Variable Selectors (Implement these)
@@ -36,25 +42,135 @@ public:
 	std::vector<int> getValuesLCVOrder ( Variable* v );
 	std::vector<int> getTournVal       ( Variable* v );
 
+	// Optional fish level: basic fish of size 2 up to size (at most 4),
+	// at nodes where the chosen check removed nothing; 0 disables it
+	void setFishSize ( int size );
+
+	// Search time allowed when no deadline is set, in seconds
+	static const float DEFAULT_TIME;
+
+	// Wall-clock deadline. Both engines return -1 once it passes; without
+	// one, solve() and solveIterative() allow time_left seconds from
+	// their start.
+	void setDeadline   ( Deadline::Clock::time_point at );
+	void setTimeBudget ( long milliseconds );
+	bool timedOut      ( void );
+
+	// Cooperative cancel: both engines return -1 soon after *flag turns
+	// true, which another thread may do at any time
+	void setCancelFlag ( const std::atomic<bool>* flag );
+	bool wasCancelled  ( void );
+
+	// Runs the check once before the search, for the checks that need it;
+	// false means the board is already inconsistent
+	bool initialCheck ( void );
+
+	// Entry point: the initial check, then solveIterative() or solve()
+	// under the deadline set, if any. Returns false, without searching,
+	// when the initial check fails.
+	bool run ( bool iterative );
+
 	// Engine Functions
-	int solve ( float time_left );
+	int solve ( float time_left = DEFAULT_TIME );
+
+	// Same search as solve(), driven by an explicit stack of frames
+	// instead of recursion
+	int solveIterative ( float time_left = DEFAULT_TIME );
 
 	bool checkConsistency ( void );
 	Variable* selectNextVariable ( void );
+
+	// One search step: decide() assigns value to v on a new trail level
+	// and runs the consistency check, undoDecision() drops the level
+	bool decide       ( Variable* v, int value );
+	void undoDecision ( void );
+	bool isComplete   ( void );
+
+	// Search state snapshots, for handing subtrees between solvers built
+	// on the same board. Loading one clears the trail.
+	std::size_t stateBytes ( void );
+	void saveState ( void* out );
+	void loadState ( const void* in );
 	std::vector<int> getNextValues ( Variable* v );
 
 	// Helper Functions
 	bool haveSolution ( void );
 	SudokuBoard getSolution ( void );
-	ConstraintNetwork getNetwork ( void );
+	ConstraintNetwork& getNetwork ( void );
+	CandidateKernel& getKernel ( void );
+	long getNodeCount ( void );
 
 private:
+	typedef Domain::Word Word;
+
+	bool lockCandidates ( int unit, int value );
+
+	// Tournament propagation
+	bool tournStep     ( int step );
+	bool nakedSingles  ( void );
+	bool hiddenSingles ( void );
+	bool nakedSubsets  ( int k );
+	bool hiddenSubsets ( int k );
+	bool eliminate     ( Variable* var, int value );
+	void place         ( Variable* var, int value );
+
+	// Fish level
+	bool runCheck   ( void );
+	bool fish       ( void );
+	bool fishDigit  ( int value, bool byRow );
+	bool fishSearch ( int value, bool byRow, int next, int depth, Word cover );
+
+	// Recursive engine
+	int search ( void );
+
+	// Iterative engine
+	void appendNextValues ( Variable* v, std::vector<int>& out );
+
 	// Properties
 	ConstraintNetwork network;
 	SudokuBoard sudokuGrid;
+	CandidateKernel kernel;
+	AllDifferent gac;
 	Trail* trail;
 
 	bool hasSolution = false;
+	long numNodes = 0;
+	Deadline deadline;
+
+	// Cells fixed since the last incremental forward check. solve()
+	// queues each decision; the first check seeds every given.
+	std::vector<Variable*> propagationQueue;
+	bool queueSeeded = false;
+
+	// Domain changes made by tournament propagation, and its scratch
+	long progress = 0;
+	std::vector<Variable*> subsetCells;
+	std::vector<int> subsetValues;
+	std::vector<Word> subsetBoard;
+
+	// Fish level: per line, the cross lines where the value can go, and
+	// the lines taking part in the current search
+	int fishSize = 0;
+	std::vector<Word> fishLines;
+	std::vector<int> fishBase;
+	int fishPicked[4];
+
+	// Iterative engine: one frame per open decision. Its values are
+	// frameValues[first, first + count) and cursor is the next one to try.
+	// The trail's own markers unwind each tried value.
+	struct Frame
+	{
+		Variable* var;
+		int first;
+		int count;
+		int cursor;
+	};
+	std::vector<Frame> frames;
+	std::vector<int> frameValues;
+
+	// Units handed to the GAC propagator; the first call checks them all
+	std::vector<int> gacUnits;
+	bool gacSeeded = false;
 
 	std::string varHeuristics;
 	std::string valHeuristics;
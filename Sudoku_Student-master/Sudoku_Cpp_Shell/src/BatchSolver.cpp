@@ -0,0 +1,178 @@
+#include "BatchSolver.hpp"
+#include "BTSolver.hpp"
+#include "FixedSolver.hpp"
+#include "SudokuBoard.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <dirent.h>
+
+/**
+ * Thread-pool batch solving; see BatchSolver.hpp.
+ */
+
+// One worker's totals, alone on its cache line
+struct alignas( 64 ) WorkerTotals
+{
+	BatchTotals totals;
+};
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+BatchSolver::BatchSolver ( std::string val_sh, std::string var_sh, std::string cc, Trail::Mode _trailMode )
+{
+	valHeuristics = val_sh;
+	varHeuristics = var_sh;
+	cChecks = cc;
+	trailMode = _trailMode;
+}
+
+// =====================================================================
+// Modifiers
+// =====================================================================
+
+void BatchSolver::setFishSize ( int size )
+{
+	fishSize = size;
+}
+
+void BatchSolver::setIterative ( bool _iterative )
+{
+	iterative = _iterative;
+}
+
+void BatchSolver::setFixed ( bool _fixed )
+{
+	fixed = _fixed;
+}
+
+void BatchSolver::setTimeBudget ( long milliseconds )
+{
+	budget = milliseconds;
+}
+
+Trail::Mode BatchSolver::getTrailMode ( void ) const
+{
+	return trailMode;
+}
+
+// =====================================================================
+// Solving
+// =====================================================================
+
+BatchTotals BatchSolver::solve ( const std::vector<std::string>& paths, int workers )
+{
+	workers = std::max( 1, workers );
+
+	std::atomic<std::size_t> next( 0 );
+	std::vector<WorkerTotals> slots( workers );
+	std::vector<std::thread> pool;
+	pool.reserve( workers );
+
+	for ( int w = 0; w < workers; ++w )
+	{
+		pool.emplace_back( [&, w] ( void )
+		{
+			Trail trail( trailMode );
+			BatchTotals& totals = slots[w].totals;
+
+			for ( std::size_t i = next.fetch_add( 1 ); i < paths.size(); i = next.fetch_add( 1 ) )
+			{
+				solveBoard( SudokuBoard( paths[i] ), trail, totals );
+				trail.clear();
+			}
+
+			totals.pushes = trail.getPushCount();
+			totals.stored = trail.getStoredPushCount();
+			totals.backtracks = trail.getUndoCount();
+		} );
+	}
+
+	for ( std::thread& t : pool )
+		t.join();
+
+	BatchTotals sum;
+	for ( const WorkerTotals& slot : slots )
+	{
+		sum.boards += slot.totals.boards;
+		sum.solutions += slot.totals.solutions;
+		sum.timeouts += slot.totals.timeouts;
+		sum.nodes += slot.totals.nodes;
+		sum.pushes += slot.totals.pushes;
+		sum.stored += slot.totals.stored;
+		sum.backtracks += slot.totals.backtracks;
+		sum.malformed += slot.totals.malformed;
+	}
+	return sum;
+}
+
+// Same steps as one board of the serial folder mode
+BatchSolver::Outcome BatchSolver::solveBoard ( const SudokuBoard& board, Trail& trail, BatchTotals& totals,
+                                               SudokuBoard::Board* grid ) const
+{
+	totals.boards++;
+
+	if ( ! board.isValid() )
+	{
+		totals.malformed++;
+		return MALFORMED;
+	}
+
+	FixedResult result;
+	if ( fixed && solveFixed( board, result ) )
+	{
+		totals.nodes += result.nodes;
+		if ( ! result.solved )
+			return UNSOLVABLE;
+
+		totals.solutions++;
+		if ( grid != nullptr )
+			*grid = result.grid;
+		return SOLVED;
+	}
+
+	BTSolver solver( board, &trail, valHeuristics, varHeuristics, cChecks );
+	solver.setFishSize( fishSize );
+	if ( budget > 0 )
+		solver.setTimeBudget( budget );
+
+	solver.run( iterative );
+
+	totals.nodes += solver.getNodeCount();
+	if ( solver.haveSolution() )
+	{
+		totals.solutions++;
+		if ( grid != nullptr )
+			*grid = solver.getSolution().view_board();
+		return SOLVED;
+	}
+
+	if ( solver.timedOut() )
+	{
+		totals.timeouts++;
+		return TIMED_OUT;
+	}
+
+	return UNSOLVABLE;
+}
+
+std::vector<std::string> BatchSolver::listFolder ( const std::string& folder )
+{
+	std::vector<std::string> paths;
+
+	DIR* dir = opendir( folder.c_str() );
+	if ( dir == NULL )
+		return paths;
+
+	struct dirent* ent;
+	while ( ( ent = readdir( dir ) ) != NULL )
+		if ( ent->d_name[0] != '.' )
+			paths.push_back( folder + "/" + ent->d_name );
+
+	closedir( dir );
+	std::sort( paths.begin(), paths.end() );
+	return paths;
+}
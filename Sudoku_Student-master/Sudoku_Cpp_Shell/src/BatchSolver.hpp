@@ -0,0 +1,73 @@
+#ifndef BATCHSOLVER_HPP
+#define BATCHSOLVER_HPP
+
+#include "SudokuBoard.hpp"
+#include "Trail.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * Solves many board files on a fixed pool of worker threads.
+ *
+ * The paths form a shared queue that is nothing but an atomic index:
+ * each worker claims the next path with one fetch_add. A worker owns its
+ * Trail, reused from board to board as the serial folder mode does, and
+ * builds a BTSolver (and so a network) per board. Counts go to a
+ * per-worker slot on its own cache line and are summed after the join,
+ * so no lock is taken and the totals equal a serial run's in any order.
+ */
+
+// Totals over a batch, named as in the serial folder mode
+struct BatchTotals
+{
+	long boards = 0;
+	long solutions = 0;
+	long timeouts = 0;
+	long nodes = 0;
+	long pushes = 0;
+	long stored = 0;
+	long backtracks = 0;
+	long malformed = 0;
+};
+
+class BatchSolver
+{
+public:
+	enum Outcome { SOLVED, UNSOLVABLE, TIMED_OUT, MALFORMED };
+
+	// Constructor
+	BatchSolver ( std::string val_sh, std::string var_sh, std::string cc,
+	              Trail::Mode trailMode = Trail::DOMAIN_COPY );
+
+	// Modifiers
+	void setFishSize   ( int size );
+	void setIterative  ( bool iterative );
+	void setFixed      ( bool fixed );
+	void setTimeBudget ( long milliseconds );
+
+	Trail::Mode getTrailMode ( void ) const;
+
+	// Solves every path with workers threads
+	BatchTotals solve ( const std::vector<std::string>& paths, int workers );
+
+	// Solves one board on trail, adding to totals. The solution goes to
+	// grid, when given.
+	Outcome solveBoard ( const SudokuBoard& board, Trail& trail, BatchTotals& totals,
+	                     SudokuBoard::Board* grid = nullptr ) const;
+
+	// Board files in folder, skipping dot files, in name order
+	static std::vector<std::string> listFolder ( const std::string& folder );
+
+private:
+	std::string valHeuristics;
+	std::string varHeuristics;
+	std::string cChecks;
+	Trail::Mode trailMode;
+	int fishSize = 0;
+	bool iterative = false;
+	bool fixed = false;
+	long budget = 0;
+};
+
+#endif
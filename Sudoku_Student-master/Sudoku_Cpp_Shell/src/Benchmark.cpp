@@ -0,0 +1,574 @@
+#include "BTSolver.hpp"
+#include "FixedSolver.hpp"
+#include "ParallelSearch.hpp"
+#include "BatchSolver.hpp"
+#include "SudokuBoard.hpp"
+#include "Trail.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+using namespace std;
+
+/**
+ * Benchmark driver. Runs the backtrack solver over a board file or a
+ * folder of boards and reports search statistics, wall time and heap
+ * allocations per search node.
+ *
+ * With FIXED, every board whose shape has a FixedSolver specialisation
+ * is also solved on it, and the two paths are compared on those boards.
+ *
+ * SCALAR forces the scalar CandidateKernel primitives during search.
+ * KERNEL skips the search and times the kernel alone, scalar against
+ * AVX2, on the starting state of every board.
+ *
+ * PARALLEL runs every board through ParallelSearch at 1, 2, 4, 8, 16 and
+ * 32 threads, and reports speedup and efficiency against one thread.
+ *
+ * BATCH solves the boards on BatchSolver pools of 1 to 32 workers, and
+ * reports boards per second and whether the totals match one worker's.
+ *
+ * DEGENERATE takes no boards. It solves empty 1xq and px1 boards, up to
+ * 9 cells a side, where blocks repeat rows or columns, and checks every
+ * solution. It exits with 1 if any is missing or wrong.
+ *
+ * Usage: Benchmark [MRV|MAD] [LCV] [FC|IFC|NOR|GAC|TOURN] [DELTA] [FISH] [ITER] [FIXED] [SCALAR|KERNEL|PARALLEL|BATCH|DEGENERATE] [-t ms] [-r repeats] <file|folder>
+ */
+
+// =====================================================================
+// Allocation Counter
+// =====================================================================
+
+static atomic<long long> numAllocations( 0 );
+
+void* operator new ( size_t size )
+{
+	numAllocations.fetch_add( 1, memory_order_relaxed );
+	void* p = malloc( size ? size : 1 );
+	if ( p == nullptr )
+		throw bad_alloc();
+	return p;
+}
+
+void* operator new[] ( size_t size )
+{
+	return operator new( size );
+}
+
+// Kept out of line, so the compiler never sees free() meet a pointer from
+// operator new at a call site; every other form forwards here
+__attribute__(( noinline )) void operator delete ( void* p ) noexcept
+{
+	free( p );
+}
+
+void operator delete[] ( void* p ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete ( void* p, size_t ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete[] ( void* p, size_t ) noexcept
+{
+	operator delete[]( p );
+}
+
+// =====================================================================
+// Helpers
+// =====================================================================
+
+// Returns the board files named by path, which may be a file or a folder
+static vector<string> listBoards ( string path )
+{
+	vector<string> files;
+
+	struct stat path_stat;
+	if ( stat( path.c_str(), &path_stat ) != 0 )
+		return files;
+
+	if ( ! S_ISDIR( path_stat.st_mode ) )
+	{
+		files.push_back( path );
+		return files;
+	}
+
+	DIR *dir = opendir( path.c_str() );
+	if ( dir == NULL )
+		return files;
+
+	struct dirent *ent;
+	while ( ( ent = readdir( dir ) ) != NULL )
+		if ( ent->d_name[0] != '.' )
+			files.push_back( path + "/" + ent->d_name );
+
+	closedir( dir );
+	sort( files.begin(), files.end() );
+	return files;
+}
+
+// True when solution keeps the clues of board and every row, column and
+// block holds each value once
+static bool isSolution ( const SudokuBoard& board, const SudokuBoard& solution )
+{
+	int p = board.get_p();
+	int q = board.get_q();
+	int N = board.get_n();
+	const SudokuBoard::Board& clues = board.view_board();
+	const SudokuBoard::Board& grid = solution.view_board();
+
+	if ( solution.get_n() != N )
+		return false;
+
+	for ( int u = 0; u < N; ++u )
+	{
+		vector<char> inRow( N + 1, 0 ), inCol( N + 1, 0 ), inBlock( N + 1, 0 );
+		for ( int k = 0; k < N; ++k )
+		{
+			int r = u / p * p + k / q;
+			int c = u % p * q + k % q;
+			int values[3] = { grid[u][k], grid[k][u], grid[r][c] };
+			vector<char>* seen[3] = { &inRow, &inCol, &inBlock };
+
+			for ( int s = 0; s < 3; ++s )
+			{
+				if ( values[s] < 1 || values[s] > N || (*seen[s])[values[s]] )
+					return false;
+				(*seen[s])[values[s]] = 1;
+			}
+
+			if ( clues[u][k] != 0 && clues[u][k] != grid[u][k] )
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Times CandidateKernel::run on each path and checks they agree
+static int benchKernel ( const vector<string>& boards, int repeats )
+{
+	const int iterations = 1000 * repeats;
+	double seconds[2] = { 0.0, 0.0 };
+	long long runs = 0;
+	long long mismatches = 0;
+
+	for ( const string& path : boards )
+	{
+		SudokuBoard board( path );
+		ConstraintNetwork network( board );
+		const NetworkState& state = network.getState();
+		int N = board.get_n();
+
+		CandidateKernel kernels[2] = { CandidateKernel( board.get_p(), board.get_q() ),
+		                               CandidateKernel( board.get_p(), board.get_q() ) };
+		kernels[0].setPath( CandidateKernel::SCALAR );
+		kernels[1].setPath( CandidateKernel::AVX2 );
+
+		bool consistent[2];
+		for ( int k = 0; k < 2; ++k )
+		{
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for ( int i = 0; i < iterations; ++i )
+				consistent[k] = kernels[k].run( state );
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+			seconds[k] += chrono::duration<double>( stop - start ).count();
+		}
+		runs += iterations;
+
+		for ( int k = 0; k < 2; ++k )
+			if ( consistent[k] )
+				kernels[k].findSingles();
+
+		bool same = consistent[0] == consistent[1]
+		         && kernels[0].nakedSingles() == kernels[1].nakedSingles();
+		for ( int c = 0; same && c < N * N; ++c )
+			same = equal( kernels[0].candidates( c ), kernels[0].candidates( c ) + Domain::WORDS,
+			              kernels[1].candidates( c ) );
+		for ( int u = 0; same && consistent[0] && u < 3 * N; ++u )
+			same = equal( kernels[0].hidden( u ), kernels[0].hidden( u ) + Domain::WORDS,
+			              kernels[1].hidden( u ) );
+		if ( ! same )
+			mismatches++;
+	}
+
+	cout << fixed << setprecision( 3 );
+	cout << "AVX2 Available: "      << ( CandidateKernel::avx2Supported() ? "yes" : "no" ) << endl;
+	cout << "Kernel Runs: "         << runs << endl;
+	cout << "Scalar us/Run: "       << seconds[0] * 1e6 / runs << endl;
+	cout << "AVX2 us/Run: "         << seconds[1] * 1e6 / runs << endl;
+	cout << "Kernel Speedup: "      << ( seconds[1] > 0.0 ? seconds[0] / seconds[1] : 0.0 ) << endl;
+	cout << "Kernel Mismatches: "   << mismatches << endl;
+	return 0;
+}
+
+// Times ParallelSearch over the boards at each thread count
+static int benchParallel ( const vector<string>& boards, const string& val_sh, const string& var_sh,
+                           const string& cc, Trail::Mode trailMode, int fishSize, long budget, int repeats )
+{
+	const int counts[] = { 1, 2, 4, 8, 16, 32 };
+	double base = 0.0;
+
+	cout << fixed << setprecision( 3 );
+	cout << "Hardware Threads: " << thread::hardware_concurrency() << endl;
+
+	for ( int threads : counts )
+	{
+		long long solutions = 0;
+		long long timeouts = 0;
+		long long nodes = 0;
+		long long steals = 0;
+		double seconds = 0.0;
+
+		for ( int r = 0; r < repeats; ++r )
+		{
+			for ( const string& path : boards )
+			{
+				SudokuBoard board( path );
+				ParallelSearch search( board, val_sh, var_sh, cc, trailMode );
+				search.setFishSize( fishSize );
+
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				ParallelResult outcome = search.solve( threads, budget );
+				chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+				seconds += chrono::duration<double>( stop - start ).count();
+				nodes += outcome.nodes;
+				steals += outcome.steals;
+				if ( outcome.solved )
+					solutions++;
+				else if ( outcome.timedOut )
+					timeouts++;
+			}
+		}
+
+		if ( threads == 1 )
+			base = seconds;
+		double speedup = seconds > 0.0 ? base / seconds : 0.0;
+
+		cout << "Threads: "        << threads
+		     << "  Solutions: "    << solutions
+		     << "  Timed Out: "    << timeouts
+		     << "  Nodes: "        << nodes
+		     << "  Steals: "       << steals
+		     << "  Time (ms): "    << seconds * 1000.0
+		     << "  Speedup: "      << speedup
+		     << "  Efficiency: "   << speedup / threads << endl;
+	}
+
+	return 0;
+}
+
+// Times BatchSolver pools of growing size over the boards
+static int benchBatch ( const vector<string>& boards, const string& val_sh, const string& var_sh,
+                        const string& cc, Trail::Mode trailMode, int fishSize, bool iterative,
+                        long budget, int repeats )
+{
+	const int counts[] = { 1, 2, 4, 8, 16, 32 };
+	BatchTotals base;
+	double baseRate = 0.0;
+
+	vector<string> paths;
+	for ( int r = 0; r < repeats; ++r )
+		paths.insert( paths.end(), boards.begin(), boards.end() );
+
+	cout << fixed << setprecision( 3 );
+	cout << "Hardware Threads: " << thread::hardware_concurrency() << endl;
+
+	for ( int workers : counts )
+	{
+		BatchSolver batch( val_sh, var_sh, cc, trailMode );
+		batch.setFishSize( fishSize );
+		batch.setIterative( iterative );
+		batch.setTimeBudget( budget );
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		BatchTotals totals = batch.solve( paths, workers );
+		double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+		double rate = seconds > 0.0 ? totals.boards / seconds : 0.0;
+
+		if ( workers == 1 )
+		{
+			base = totals;
+			baseRate = rate;
+		}
+		bool match = totals.solutions == base.solutions && totals.pushes == base.pushes
+		          && totals.stored == base.stored && totals.backtracks == base.backtracks;
+
+		cout << "Workers: "        << workers
+		     << "  Solutions: "    << totals.solutions
+		     << "  Trail Pushes: " << totals.pushes
+		     << "  Backtracks: "   << totals.backtracks
+		     << "  Boards/s: "     << rate
+		     << "  Speedup: "      << ( baseRate > 0.0 ? rate / baseRate : 0.0 )
+		     << "  Match: "        << ( match ? "yes" : "no" ) << endl;
+	}
+
+	return 0;
+}
+
+// Solves empty boards whose blocks repeat a row or a column
+static int benchDegenerate ( const string& val_sh, const string& var_sh, const string& cc,
+                             Trail::Mode trailMode, int fishSize )
+{
+	long long boards = 0;
+	long long solutions = 0;
+	long long failures = 0;
+
+	for ( int n = 1; n <= 9; ++n )
+	{
+		for ( int flip = 0; flip < ( n == 1 ? 1 : 2 ); ++flip )
+		{
+			int p = flip ? n : 1;
+			int q = flip ? 1 : n;
+			SudokuBoard board( p, q, SudokuBoard::Board( n, SudokuBoard::Row( n, 0 ) ) );
+			Trail trail( trailMode );
+			BTSolver solver( board, &trail, val_sh, var_sh, cc );
+			solver.setFishSize( fishSize );
+
+			solver.run( false );
+
+			boards++;
+			if ( solver.haveSolution() && isSolution( board, solver.getSolution() ) )
+				solutions++;
+			else
+			{
+				failures++;
+				cout << "Failed: " << p << "x" << q << endl;
+			}
+		}
+	}
+
+	cout << "Boards: "          << boards << endl;
+	cout << "Solutions Found: " << solutions << endl;
+	cout << "Failures: "        << failures << endl;
+	return failures ? 1 : 0;
+}
+
+// =====================================================================
+// Main
+// =====================================================================
+
+int main ( int argc, char *argv[] )
+{
+	string file   = "";
+	string var_sh = "";
+	string val_sh = "";
+	string cc     = "";
+	Trail::Mode trailMode = Trail::DOMAIN_COPY;
+	int repeats   = 1;
+	bool fixed    = false;
+	int fishSize  = 0;
+	bool iterative = false;
+	long budget   = 0;
+	bool scalar   = false;
+	bool kernel   = false;
+	bool parallel = false;
+	bool batch    = false;
+	bool degenerate = false;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		string token = argv[i];
+
+		if ( token == "MRV" )
+			var_sh = "MinimumRemainingValue";
+
+		else if ( token == "MAD" )
+			var_sh = "MRVwithTieBreaker";
+
+		else if ( token == "LCV" )
+			val_sh = "LeastConstrainingValue";
+
+		else if ( token == "FC" )
+			cc = "forwardChecking";
+
+		else if ( token == "IFC" )
+			cc = "incrementalForwardChecking";
+
+		else if ( token == "NOR" )
+			cc = "norvigCheck";
+
+		else if ( token == "GAC" )
+			cc = "generalizedArcConsistency";
+
+		else if ( token == "TOURN" )
+		{
+			var_sh = "tournVar";
+			val_sh = "tournVal";
+			cc     = "tournCC";
+		}
+
+		else if ( token == "DELTA" )
+			trailMode = Trail::DELTA;
+
+		else if ( token == "FIXED" )
+			fixed = true;
+
+		else if ( token == "FISH" )
+			fishSize = 4;
+
+		else if ( token == "ITER" )
+			iterative = true;
+
+		else if ( token == "SCALAR" )
+			scalar = true;
+
+		else if ( token == "KERNEL" )
+			kernel = true;
+
+		else if ( token == "PARALLEL" )
+			parallel = true;
+
+		else if ( token == "BATCH" )
+			batch = true;
+
+		else if ( token == "DEGENERATE" )
+			degenerate = true;
+
+		else if ( token == "-t" && i + 1 < argc )
+			budget = atol( argv[++i] );
+
+		else if ( token == "-r" && i + 1 < argc )
+			repeats = max( 1, atoi( argv[++i] ) );
+
+		else
+			file = token;
+	}
+
+	if ( degenerate )
+		return benchDegenerate( val_sh, var_sh, cc, trailMode, fishSize );
+
+	vector<string> boards = listBoards( file );
+	if ( boards.empty() )
+	{
+		cout << "[ERROR] No boards found at '" << file << "'." << endl;
+		return 1;
+	}
+
+	if ( kernel )
+		return benchKernel( boards, repeats );
+
+	if ( parallel )
+		return benchParallel( boards, val_sh, var_sh, cc, trailMode, fishSize, budget, repeats );
+
+	if ( batch )
+		return benchBatch( boards, val_sh, var_sh, cc, trailMode, fishSize, iterative, budget, repeats );
+
+	long long solutions = 0;
+	long long timeouts = 0;
+	long long nodes = 0;
+	long long allocations = 0;
+	long long pushes = 0;
+	long long stored = 0;
+	long long pushBytes = 0;
+	long long undoBytes = 0;
+	double seconds = 0.0;
+
+	// Boards that also ran on a specialisation
+	long long fixedRuns = 0;
+	long long fixedSolutions = 0;
+	long long fixedNodes = 0;
+	long long mismatches = 0;
+	double fixedSeconds = 0.0;
+	double genericSeconds = 0.0;
+
+	for ( int r = 0; r < repeats; ++r )
+	{
+		for ( const string& path : boards )
+		{
+			SudokuBoard board( path );
+			Trail trail( trailMode );
+			BTSolver solver( board, &trail, val_sh, var_sh, cc );
+			solver.setFishSize( fishSize );
+			if ( scalar )
+				solver.getKernel().setPath( CandidateKernel::SCALAR );
+
+			long long allocsBefore = numAllocations.load();
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+			if ( budget > 0 )
+				solver.setTimeBudget( budget );
+
+			solver.run( iterative );
+
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+			allocations += numAllocations.load() - allocsBefore;
+			double elapsed = chrono::duration<double>( stop - start ).count();
+			seconds += elapsed;
+
+			nodes += solver.getNodeCount();
+			pushes += trail.getPushCount();
+			stored += trail.getStoredPushCount();
+			pushBytes += trail.getPushBytes();
+			undoBytes += trail.getUndoBytes();
+			if ( solver.haveSolution() )
+				solutions++;
+			else if ( solver.timedOut() )
+				timeouts++;
+
+			if ( ! fixed )
+				continue;
+
+			FixedResult result;
+			start = chrono::steady_clock::now();
+			bool specialised = solveFixed( board, result );
+			stop = chrono::steady_clock::now();
+
+			if ( specialised )
+			{
+				fixedRuns++;
+				fixedNodes += result.nodes;
+				fixedSeconds += chrono::duration<double>( stop - start ).count();
+				genericSeconds += elapsed;
+				if ( result.solved )
+					fixedSolutions++;
+				if ( result.solved != solver.haveSolution() )
+					mismatches++;
+			}
+		}
+	}
+
+	long long runs = (long long)boards.size() * repeats;
+
+	cout << fixed << setprecision( 3 );
+	cout << "Boards: "          << runs << endl;
+	cout << "Solutions Found: " << solutions << endl;
+	cout << "Timed Out: "       << timeouts << endl;
+	cout << "Nodes: "           << nodes << endl;
+	cout << "Allocations: "     << allocations << endl;
+	cout << "Allocs/Node: "     << ( nodes ? (double)allocations / nodes : 0.0 ) << endl;
+	cout << "Trail Pushes: "    << pushes << endl;
+	cout << "Stored Pushes: "   << stored << endl;
+	cout << "Push Bytes: "      << pushBytes << endl;
+	cout << "Undo Bytes: "      << undoBytes << endl;
+	cout << "Time (ms): "       << seconds * 1000.0 << endl;
+	cout << "us/Node: "         << ( nodes ? seconds * 1e6 / nodes : 0.0 ) << endl;
+
+	if ( fixed )
+	{
+		cout << "Specialised Boards: "    << fixedRuns << endl;
+		cout << "Specialised Solutions: " << fixedSolutions << endl;
+		cout << "Specialised Nodes: "     << fixedNodes << endl;
+		cout << "Specialised Time (ms): " << fixedSeconds * 1000.0 << endl;
+		cout << "Generic Time (ms): "     << genericSeconds * 1000.0 << endl;
+		cout << "Speedup: "               << ( fixedSeconds > 0.0 ? genericSeconds / fixedSeconds : 0.0 ) << endl;
+		cout << "Mismatches: "            << mismatches << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include "BoardParser.hpp"
+
+#include <cstdint>
+
+/**
+ * Single-pass board parser; see BoardParser.hpp.
+ */
+
+// Cells in the one-line 9x9 form
+static const std::size_t DOT_CELLS = 81;
+
+static bool isSpace ( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+// Value of a digit in base 10 or 36, or -1
+static int digitValue ( char c, int base )
+{
+	if ( c >= '0' && c <= '9' )
+		return c - '0';
+	if ( c >= 'A' && c <= 'Z' && base == 36 )
+		return c - 'A' + 10;
+	return -1;
+}
+
+// Clues seen so far in each row, column and block; bit v-1 for value v
+class UnitMasks
+{
+public:
+	UnitMasks ( int _p, int _q )
+	{
+		p = _p;
+		q = _q;
+		for ( int i = 0; i < p * q; ++i )
+			rows[i] = cols[i] = blocks[i] = 0;
+	}
+
+	// Records value at (row, col); names the unit already holding it
+	const char* place ( int row, int col, int value )
+	{
+		std::uint64_t bit = std::uint64_t( 1 ) << ( value - 1 );
+		int block = row / p * p + col / q;
+
+		if ( rows[row] & bit )
+			return "duplicate clue in row";
+		if ( cols[col] & bit )
+			return "duplicate clue in column";
+		if ( blocks[block] & bit )
+			return "duplicate clue in block";
+
+		rows[row] |= bit;
+		cols[col] |= bit;
+		blocks[block] |= bit;
+		return nullptr;
+	}
+
+private:
+	int p;
+	int q;
+	std::uint64_t rows[BoardParser::MAX_N];
+	std::uint64_t cols[BoardParser::MAX_N];
+	std::uint64_t blocks[BoardParser::MAX_N];
+};
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+BoardParser::BoardParser ( const char* _data, std::size_t _length, long firstLine )
+{
+	data = _data;
+	length = _length;
+	line = firstLine;
+}
+
+// =====================================================================
+// Parsing
+// =====================================================================
+
+bool BoardParser::parse ( int& p, int& q, SudokuBoard::Board& grid )
+{
+	if ( ! skipSpace() )
+		return fail( "empty board" );
+
+	std::size_t end = pos;
+	while ( end < length && ! isSpace( data[end] ) )
+		++end;
+	if ( isDotForm( data + pos, end - pos ) )
+	{
+		p = q = 3;
+		return parseDots( grid );
+	}
+
+	// p and q are decimal, the cells base-36
+	long rows;
+	long cols;
+	if ( ! readToken( rows, MAX_N, "block size out of range", 10 ) )
+		return false;
+	if ( rows < 1 )
+		return failAt( tokenLine, tokenColumn, "block size out of range" );
+
+	if ( ! readToken( cols, MAX_N, "block size out of range", 10 ) )
+		return false;
+	if ( cols < 1 )
+		return failAt( tokenLine, tokenColumn, "block size out of range" );
+	if ( rows * cols > MAX_N )
+		return failAt( tokenLine, tokenColumn, "board larger than 64x64" );
+
+	p = rows;
+	q = cols;
+	return parseCells( p, q, grid );
+}
+
+const ParseError& BoardParser::getError ( void ) const
+{
+	return error;
+}
+
+bool BoardParser::isDotForm ( const char* data, std::size_t length )
+{
+	if ( length != DOT_CELLS )
+		return false;
+
+	for ( std::size_t i = 0; i < DOT_CELLS; ++i )
+		if ( data[i] != '.' && ( data[i] < '0' || data[i] > '9' ) )
+			return false;
+	return true;
+}
+
+// =====================================================================
+// Private Helper Methods
+// =====================================================================
+
+// Moves past whitespace, counting lines; false at the end of the buffer
+bool BoardParser::skipSpace ( void )
+{
+	for ( ; pos < length && isSpace( data[pos] ); ++pos )
+	{
+		if ( data[pos] == '\n' )
+		{
+			++line;
+			lineStart = pos + 1;
+		}
+	}
+	return pos < length;
+}
+
+// Decodes the next token, which must not exceed limit
+bool BoardParser::readToken ( long& value, long limit, const char* rangeMessage, int base )
+{
+	if ( ! skipSpace() )
+		return fail( "unexpected end of board" );
+
+	tokenLine = line;
+	tokenColumn = pos - lineStart + 1;
+
+	value = 0;
+	for ( ; pos < length && ! isSpace( data[pos] ); ++pos )
+	{
+		int d = digitValue( data[pos], base );
+		if ( d < 0 )
+			return failAt( line, pos - lineStart + 1, base == 36 ? "invalid base-36 digit" : "invalid digit" );
+
+		value = value * base + d;
+		if ( value > limit )
+			return failAt( tokenLine, tokenColumn, rangeMessage );
+	}
+	return true;
+}
+
+bool BoardParser::parseCells ( int p, int q, SudokuBoard::Board& grid )
+{
+	int N = p * q;
+	UnitMasks units( p, q );
+
+	grid.resize( N );
+	for ( int i = 0; i < N; ++i )
+	{
+		SudokuBoard::Row& row = grid[i];
+		row.assign( N, 0 );
+
+		for ( int j = 0; j < N; ++j )
+		{
+			long value;
+			if ( ! readToken( value, N, "value out of range" ) )
+				return false;
+			if ( value == 0 )
+				continue;
+
+			const char* duplicate = units.place( i, j, value );
+			if ( duplicate != nullptr )
+				return failAt( tokenLine, tokenColumn, duplicate );
+			row[j] = value;
+		}
+	}
+
+	if ( skipSpace() )
+		return fail( "unexpected token after the last cell" );
+	return true;
+}
+
+bool BoardParser::parseDots ( SudokuBoard::Board& grid )
+{
+	UnitMasks units( 3, 3 );
+	long column = pos - lineStart + 1;
+
+	grid.resize( 9 );
+	for ( int i = 0; i < 9; ++i )
+	{
+		SudokuBoard::Row& row = grid[i];
+		row.assign( 9, 0 );
+
+		for ( int j = 0; j < 9; ++j, ++pos )
+		{
+			char c = data[pos];
+			if ( c == '.' || c == '0' )
+				continue;
+
+			const char* duplicate = units.place( i, j, c - '0' );
+			if ( duplicate != nullptr )
+				return failAt( line, column + i * 9 + j, duplicate );
+			row[j] = c - '0';
+		}
+	}
+
+	if ( skipSpace() )
+		return fail( "unexpected token after the last cell" );
+	return true;
+}
+
+// Fails at the cursor
+bool BoardParser::fail ( const char* message )
+{
+	return failAt( line, pos - lineStart + 1, message );
+}
+
+bool BoardParser::failAt ( long _line, long column, const char* message )
+{
+	error.line = _line;
+	error.column = column;
+	error.message = message;
+	return false;
+}
@@ -0,0 +1,69 @@
+#ifndef BOARDPARSER_HPP
+#define BOARDPARSER_HPP
+
+#include "SudokuBoard.hpp"
+
+#include <cstddef>
+
+/**
+ * Single-pass board parser over a byte buffer.
+ *
+ * A board is "p q" in decimal followed by the N*N cells as base-36 odometer tokens
+ * (0 for an empty cell), separated by any whitespace. The 81-character
+ * 9x9 form, with '.' or '0' for an empty cell, is accepted as well.
+ *
+ * Tokens are decoded in place as the cursor passes them, so no string is
+ * built and nothing is allocated beyond the rows of the grid, whose
+ * storage is reused when the caller passes the same grid again. Every
+ * clue is checked as it is read: values must not exceed N, and no row,
+ * column or block may hold a clue twice. The first problem stops the
+ * parse and is reported with its line and column.
+ */
+
+// Where and why a parse failed; message is a string literal
+struct ParseError
+{
+	long line = 0;
+	long column = 0;
+	const char* message = "";
+};
+
+class BoardParser
+{
+public:
+	// Largest N accepted; one 64-bit mask per unit tracks its clues
+	static const int MAX_N = 64;
+
+	// Constructor; firstLine is the line number of data[0]
+	BoardParser ( const char* data, std::size_t length, long firstLine = 1 );
+
+	// Parses the whole buffer into p, q and grid; false on the first error
+	bool parse ( int& p, int& q, SudokuBoard::Board& grid );
+
+	const ParseError& getError ( void ) const;
+
+	// True when data is exactly the 81-character 9x9 form
+	static bool isDotForm ( const char* data, std::size_t length );
+
+private:
+	const char* data;
+	std::size_t length;
+	std::size_t pos = 0;
+	long line;
+	std::size_t lineStart = 0;
+
+	// Start of the token last read, for error positions
+	long tokenLine = 0;
+	long tokenColumn = 0;
+
+	ParseError error;
+
+	bool skipSpace ( void );
+	bool readToken ( long& value, long limit, const char* rangeMessage, int base = 36 );
+	bool parseCells ( int p, int q, SudokuBoard::Board& grid );
+	bool parseDots ( SudokuBoard::Board& grid );
+	bool fail ( const char* message );
+	bool failAt ( long line, long column, const char* message );
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "BoardWriter.hpp"
+
+/**
+ * Buffered board output; see BoardWriter.hpp.
+ */
+
+// Odometer tokens of 0 .. TABLE_SIZE-1, each one or two characters
+class DigitTable
+{
+public:
+	static const int TABLE_SIZE = 36 * 36;
+
+	DigitTable ( void )
+	{
+		for ( int n = 0; n < TABLE_SIZE; ++n )
+		{
+			if ( n < 36 )
+			{
+				text[n][0] = digit( n );
+				length[n] = 1;
+			}
+			else
+			{
+				text[n][0] = digit( n / 36 );
+				text[n][1] = digit( n % 36 );
+				length[n] = 2;
+			}
+		}
+	}
+
+	void append ( std::string& out, int n ) const
+	{
+		if ( n >= 0 && n < TABLE_SIZE )
+		{
+			out.append( text[n], length[n] );
+			return;
+		}
+
+		// Larger than any board holds; converted the slow way
+		char reversed[16];
+		int size = 0;
+		for ( ; n > 0; n /= 36 )
+			reversed[size++] = digit( n % 36 );
+		while ( size > 0 )
+			out += reversed[--size];
+	}
+
+private:
+	char text[TABLE_SIZE][2];
+	unsigned char length[TABLE_SIZE];
+
+	static char digit ( int r )
+	{
+		return r < 10 ? '0' + r : 'A' + r - 10;
+	}
+};
+
+static const DigitTable DIGITS;
+
+// Decimal, as the "P:" and "Q:" header prints p and q
+static void appendDecimal ( std::string& out, int n )
+{
+	char reversed[16];
+	int size = 0;
+	do
+	{
+		reversed[size++] = '0' + n % 10;
+		n /= 10;
+	} while ( n > 0 );
+
+	while ( size > 0 )
+		out += reversed[--size];
+}
+
+// =====================================================================
+// Constructor / Destructor
+// =====================================================================
+
+BoardWriter::BoardWriter ( std::ostream& _out, Format _format )
+: out( _out )
+{
+	format = _format;
+	buffer.reserve( BLOCK_SIZE + BLOCK_SIZE / 4 );
+}
+
+BoardWriter::~BoardWriter ( void )
+{
+	flush();
+}
+
+BoardWriter::Format BoardWriter::getFormat ( void ) const
+{
+	return format;
+}
+
+// =====================================================================
+// Writing
+// =====================================================================
+
+void BoardWriter::write ( const SudokuBoard& board )
+{
+	write( "", board.get_p(), board.get_q(), board.view_board() );
+}
+
+void BoardWriter::write ( const std::string& name, int p, int q, const SudokuBoard::Board& grid )
+{
+	appendBoard( buffer, name, p, q, grid, format );
+	flushFull();
+}
+
+void BoardWriter::writeFailure ( const std::string& name, const std::string& reason )
+{
+	appendFailure( buffer, name, reason, format );
+	flushFull();
+}
+
+void BoardWriter::writeText ( const std::string& text )
+{
+	buffer += text;
+	flushFull();
+}
+
+void BoardWriter::flush ( void )
+{
+	if ( ! buffer.empty() )
+		out.write( buffer.data(), buffer.size() );
+	out.flush();
+	buffer.clear();
+}
+
+// Writes a block once one has gathered; clear() keeps the capacity
+void BoardWriter::flushFull ( void )
+{
+	if ( buffer.size() < BLOCK_SIZE )
+		return;
+
+	out.write( buffer.data(), buffer.size() );
+	buffer.clear();
+}
+
+// =====================================================================
+// Formatting
+// =====================================================================
+
+void BoardWriter::appendBoard ( std::string& text, const std::string& name, int p, int q,
+                                const SudokuBoard::Board& grid, Format format )
+{
+	if ( format == PRETTY )
+	{
+		if ( ! name.empty() )
+			text.append( "Board: " ).append( name ) += '\n';
+		appendPretty( text, p, q, grid );
+		text += '\n';
+	}
+	else if ( format == COMPACT )
+	{
+		appendCompact( text, p, q, grid );
+	}
+}
+
+void BoardWriter::appendFailure ( std::string& text, const std::string& name, const std::string& reason,
+                                  Format format )
+{
+	if ( format == PRETTY )
+	{
+		if ( ! name.empty() )
+			text.append( "Board: " ).append( name ) += '\n';
+		text.append( reason ) += '\n';
+	}
+	else if ( format == COMPACT )
+	{
+		text.append( "# " ).append( name ).append( ": " ).append( reason ) += '\n';
+	}
+}
+
+void BoardWriter::appendPretty ( std::string& text, int p, int q, const SudokuBoard::Board& grid )
+{
+	int N = p*q;
+
+	text.append( "P:  " );
+	appendDecimal( text, p );
+	text.append( "\tQ:  " );
+	appendDecimal( text, q );
+	text += '\n';
+
+	for ( int i = 0; i < N; ++i )
+	{
+		for ( int j = 0; j < N; ++j )
+		{
+			DIGITS.append( text, grid[i][j] );
+			text += ' ';
+
+			if ( (j+1) % q == 0 && j != 0 && j != N-1 )
+				text.append( "| " );
+		}
+
+		text += '\n';
+
+		if ( (i+1) % p == 0 && i != 0 && i != N-1 )
+		{
+			for ( int k = 0; k < N+p-1; ++k )
+				text.append( "- " );
+			text += '\n';
+		}
+	}
+}
+
+void BoardWriter::appendCompact ( std::string& text, int p, int q, const SudokuBoard::Board& grid )
+{
+	int N = p*q;
+
+	if ( p == 3 && q == 3 )
+	{
+		for ( int i = 0; i < N; ++i )
+			for ( int j = 0; j < N; ++j )
+				text += grid[i][j] == 0 ? '.' : char( '0' + grid[i][j] );
+	}
+	else
+	{
+		appendDecimal( text, p );
+		text += ' ';
+		appendDecimal( text, q );
+		for ( int i = 0; i < N; ++i )
+		{
+			for ( int j = 0; j < N; ++j )
+			{
+				text += ' ';
+				DIGITS.append( text, grid[i][j] );
+			}
+		}
+	}
+
+	text += '\n';
+}
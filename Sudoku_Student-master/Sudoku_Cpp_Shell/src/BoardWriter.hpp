@@ -0,0 +1,72 @@
+#ifndef BOARDWRITER_HPP
+#define BOARDWRITER_HPP
+
+#include "SudokuBoard.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+/**
+ * Buffered board output for runs that print many solutions.
+ *
+ * Boards are formatted straight into one reusable buffer, and the buffer
+ * goes to the stream in blocks of BLOCK_SIZE bytes, so printing a board
+ * costs no stringstream and no system call. Cell values are copied from
+ * a table of odometer tokens built once, rather than converted digit by
+ * digit.
+ *
+ * PRETTY is SudokuBoard::toString's layout, with '|' between blocks
+ * and a row of '-' between bands. COMPACT is one line per board that a
+ * PuzzleFile reads back: the 81-character form for a 3x3-block board,
+ * otherwise "p q" and the cells. NONE prints no boards, only errors.
+ */
+
+class BoardWriter
+{
+public:
+	enum Format { PRETTY, COMPACT, NONE };
+
+	// Bytes gathered before a write to the stream
+	static const std::size_t BLOCK_SIZE = 1 << 16;
+
+	// Constructor / Destructor; the destructor flushes
+	BoardWriter ( std::ostream& out, Format format = PRETTY );
+	~BoardWriter ( void );
+
+	BoardWriter ( const BoardWriter& ) = delete;
+	BoardWriter& operator= ( const BoardWriter& ) = delete;
+
+	Format getFormat ( void ) const;
+
+	// A board; in PRETTY, a non-empty name is printed as a header
+	void write ( const SudokuBoard& board );
+	void write ( const std::string& name, int p, int q, const SudokuBoard::Board& grid );
+
+	// A board with no solution, reason being e.g. "Timed out". COMPACT
+	// prints it as a '#' comment line.
+	void writeFailure ( const std::string& name, const std::string& reason );
+
+	// Text passed through as is, in every format
+	void writeText ( const std::string& text );
+
+	// Sends everything buffered to the stream
+	void flush ( void );
+
+	// The same formatting, appended to text
+	static void appendBoard   ( std::string& text, const std::string& name, int p, int q,
+	                            const SudokuBoard::Board& grid, Format format );
+	static void appendFailure ( std::string& text, const std::string& name, const std::string& reason,
+	                            Format format );
+	static void appendPretty  ( std::string& text, int p, int q, const SudokuBoard::Board& grid );
+	static void appendCompact ( std::string& text, int p, int q, const SudokuBoard::Board& grid );
+
+private:
+	std::ostream& out;
+	Format format;
+	std::string buffer;
+
+	void flushFull ( void );
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+/**
+ * Bounded lock-free queue for any number of producers and consumers
+ * (Vyukov's array queue).
+ *
+ * Every slot carries a sequence number telling whose turn it is: a
+ * producer may fill slot pos & mask when its sequence equals pos, a
+ * consumer may empty it when it equals pos + 1. Producers and consumers
+ * only contend on their own position counter, each claimed with a CAS.
+ *
+ * The capacity is fixed, rounded up to a power of two. push() and pop()
+ * yield while the queue is full or empty, so a fast stage is held back
+ * by a slow one instead of growing the queue.
+ */
+
+template<typename T>
+class BoundedQueue
+{
+public:
+	// Constructor
+	explicit BoundedQueue ( std::size_t capacity );
+
+	BoundedQueue ( const BoundedQueue& ) = delete;
+	BoundedQueue& operator= ( const BoundedQueue& ) = delete;
+
+	// Non-blocking; item is only moved from on success
+	bool tryPush ( T& item );
+	bool tryPop  ( T& item );
+
+	// Blocking, yielding while the queue is full / empty
+	void push ( T item );
+	void pop  ( T& item );
+
+	// Accessors; size() is a snapshot that may be stale at once
+	std::size_t size     ( void ) const;
+	std::size_t capacity ( void ) const;
+
+private:
+	struct Slot
+	{
+		std::atomic<std::size_t> sequence;
+		T data;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	std::size_t mask;
+
+	alignas( 64 ) std::atomic<std::size_t> enqueuePos;
+	alignas( 64 ) std::atomic<std::size_t> dequeuePos;
+};
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue ( std::size_t capacity )
+{
+	std::size_t size = 2;
+	while ( size < capacity )
+		size *= 2;
+
+	slots.reset( new Slot[size] );
+	mask = size - 1;
+	for ( std::size_t i = 0; i < size; ++i )
+		slots[i].sequence.store( i, std::memory_order_relaxed );
+
+	enqueuePos.store( 0, std::memory_order_relaxed );
+	dequeuePos.store( 0, std::memory_order_relaxed );
+}
+
+// =====================================================================
+// Queue Operations
+// =====================================================================
+
+template<typename T>
+bool BoundedQueue<T>::tryPush ( T& item )
+{
+	std::size_t pos = enqueuePos.load( std::memory_order_relaxed );
+	while ( true )
+	{
+		Slot& slot = slots[pos & mask];
+		std::size_t seq = slot.sequence.load( std::memory_order_acquire );
+		std::ptrdiff_t turn = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+
+		if ( turn == 0 )
+		{
+			if ( enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+			{
+				slot.data = std::move( item );
+				slot.sequence.store( pos + 1, std::memory_order_release );
+				return true;
+			}
+		}
+		else if ( turn < 0 )
+		{
+			return false;
+		}
+		else
+		{
+			pos = enqueuePos.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+template<typename T>
+bool BoundedQueue<T>::tryPop ( T& item )
+{
+	std::size_t pos = dequeuePos.load( std::memory_order_relaxed );
+	while ( true )
+	{
+		Slot& slot = slots[pos & mask];
+		std::size_t seq = slot.sequence.load( std::memory_order_acquire );
+		std::ptrdiff_t turn = (std::ptrdiff_t)seq - (std::ptrdiff_t)( pos + 1 );
+
+		if ( turn == 0 )
+		{
+			if ( dequeuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+			{
+				item = std::move( slot.data );
+				slot.sequence.store( pos + mask + 1, std::memory_order_release );
+				return true;
+			}
+		}
+		else if ( turn < 0 )
+		{
+			return false;
+		}
+		else
+		{
+			pos = dequeuePos.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+template<typename T>
+void BoundedQueue<T>::push ( T item )
+{
+	while ( ! tryPush( item ) )
+		std::this_thread::yield();
+}
+
+template<typename T>
+void BoundedQueue<T>::pop ( T& item )
+{
+	while ( ! tryPop( item ) )
+		std::this_thread::yield();
+}
+
+// =====================================================================
+// Accessors
+// =====================================================================
+
+template<typename T>
+std::size_t BoundedQueue<T>::size ( void ) const
+{
+	std::size_t head = dequeuePos.load( std::memory_order_relaxed );
+	std::size_t tail = enqueuePos.load( std::memory_order_relaxed );
+	return tail > head ? tail - head : 0;
+}
+
+template<typename T>
+std::size_t BoundedQueue<T>::capacity ( void ) const
+{
+	return mask + 1;
+}
+
+#endif
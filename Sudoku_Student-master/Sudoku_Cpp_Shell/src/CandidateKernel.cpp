@@ -0,0 +1,366 @@
+#include "CandidateKernel.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNEL_X86 1
+#endif
+
+/**
+ * Bulk candidate computation over a whole board, with scalar and AVX2
+ * primitives chosen at runtime.
+ */
+
+typedef Domain::Word Word;
+
+static const int W = Domain::WORDS;
+
+// =====================================================================
+// Primitives
+// =====================================================================
+
+// All primitives work on n words, n a multiple of WORDS, where word i
+// belongs to mask word i % WORDS. "once" / "twice" pairs record the bits
+// seen at least once / at least twice.
+struct CandidateKernel::Ops
+{
+	// Element-wise: twice |= once & src, once |= src
+	void ( *accumulate )    ( Word* once, Word* twice, const Word* src, int n );
+	// Folds the n / WORDS masks of src into the single mask once / twice
+	void ( *reduce )        ( Word* once, Word* twice, const Word* src, int n );
+	// dst = src | pattern, pattern being one mask repeated
+	void ( *orPattern )     ( Word* dst, const Word* src, const Word* pattern, int n );
+	// dst = src & ~( excl | pattern )
+	void ( *andNotPattern ) ( Word* dst, const Word* src, const Word* excl, const Word* pattern, int n );
+};
+
+static void scalarAccumulate ( Word* once, Word* twice, const Word* src, int n )
+{
+	for ( int i = 0; i < n; ++i )
+	{
+		twice[i] |= once[i] & src[i];
+		once[i]  |= src[i];
+	}
+}
+
+static void scalarReduce ( Word* once, Word* twice, const Word* src, int n )
+{
+	for ( int i = 0; i < n; i += W )
+		scalarAccumulate( once, twice, src + i, W );
+}
+
+static void scalarOrPattern ( Word* dst, const Word* src, const Word* pattern, int n )
+{
+	for ( int i = 0; i < n; ++i )
+		dst[i] = src[i] | pattern[i % W];
+}
+
+static void scalarAndNotPattern ( Word* dst, const Word* src, const Word* excl, const Word* pattern, int n )
+{
+	for ( int i = 0; i < n; ++i )
+		dst[i] = src[i] & ~( excl[i] | pattern[i % W] );
+}
+
+static const CandidateKernel::Ops* scalarOps ( void );
+static const CandidateKernel::Ops* avx2Ops ( void );
+
+#ifdef KERNEL_X86
+
+// A 256-bit register holds 4 words, i.e. 4 / WORDS whole masks, so the
+// AVX2 path requires WORDS to divide 4.
+#define AVX2_TARGET __attribute__(( target( "avx2" ) ))
+
+AVX2_TARGET static inline __m256i load ( const Word* p )
+{
+	return _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+}
+
+AVX2_TARGET static inline void store ( Word* p, __m256i v )
+{
+	_mm256_storeu_si256( reinterpret_cast<__m256i*>( p ), v );
+}
+
+AVX2_TARGET static inline __m256i broadcast ( const Word* pattern )
+{
+	return _mm256_set_epi64x( (long long)pattern[3 % W], (long long)pattern[2 % W],
+	                          (long long)pattern[1 % W], (long long)pattern[0 % W] );
+}
+
+AVX2_TARGET static void avx2Accumulate ( Word* once, Word* twice, const Word* src, int n )
+{
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 )
+	{
+		__m256i o = load( once + i );
+		__m256i s = load( src + i );
+		store( twice + i, _mm256_or_si256( load( twice + i ), _mm256_and_si256( o, s ) ) );
+		store( once + i, _mm256_or_si256( o, s ) );
+	}
+	scalarAccumulate( once + i, twice + i, src + i, n - i );
+}
+
+AVX2_TARGET static void avx2Reduce ( Word* once, Word* twice, const Word* src, int n )
+{
+	__m256i o = _mm256_setzero_si256();
+	__m256i t = _mm256_setzero_si256();
+
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 )
+	{
+		__m256i s = load( src + i );
+		t = _mm256_or_si256( t, _mm256_and_si256( o, s ) );
+		o = _mm256_or_si256( o, s );
+	}
+
+	// Fold the lanes, which hold 4 / WORDS partial masks
+	alignas( 32 ) Word lo[4];
+	alignas( 32 ) Word lt[4];
+	store( lo, o );
+	store( lt, t );
+	for ( int l = 0; l < 4; l += W )
+	{
+		for ( int w = 0; w < W; ++w )
+		{
+			twice[w] |= lt[l + w] | ( once[w] & lo[l + w] );
+			once[w]  |= lo[l + w];
+		}
+	}
+
+	scalarReduce( once, twice, src + i, n - i );
+}
+
+AVX2_TARGET static void avx2OrPattern ( Word* dst, const Word* src, const Word* pattern, int n )
+{
+	__m256i pat = broadcast( pattern );
+
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 )
+		store( dst + i, _mm256_or_si256( load( src + i ), pat ) );
+	scalarOrPattern( dst + i, src + i, pattern, n - i );
+}
+
+AVX2_TARGET static void avx2AndNotPattern ( Word* dst, const Word* src, const Word* excl, const Word* pattern, int n )
+{
+	__m256i pat = broadcast( pattern );
+
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 )
+		store( dst + i, _mm256_andnot_si256( _mm256_or_si256( load( excl + i ), pat ), load( src + i ) ) );
+	scalarAndNotPattern( dst + i, src + i, excl + i, pattern, n - i );
+}
+
+static const CandidateKernel::Ops* avx2Ops ( void )
+{
+	static const CandidateKernel::Ops ops = { avx2Accumulate, avx2Reduce, avx2OrPattern, avx2AndNotPattern };
+	return &ops;
+}
+
+#else
+
+static const CandidateKernel::Ops* avx2Ops ( void )
+{
+	return scalarOps();
+}
+
+#endif
+
+static const CandidateKernel::Ops* scalarOps ( void )
+{
+	static const CandidateKernel::Ops ops = { scalarAccumulate, scalarReduce, scalarOrPattern, scalarAndNotPattern };
+	return &ops;
+}
+
+// =====================================================================
+// Constructors
+// =====================================================================
+
+CandidateKernel::CandidateKernel ( void )
+{
+	ops = scalarOps();
+}
+
+CandidateKernel::CandidateKernel ( int _p, int _q )
+{
+	p = _p;
+	q = _q;
+	N = p * q;
+
+	assigned.assign( (std::size_t)N * N * W, 0 );
+	cand.assign( (std::size_t)N * N * W, 0 );
+	used.assign( 3 * N * W, 0 );
+	usedTwice.assign( 3 * N * W, 0 );
+	seen.assign( 3 * N * W, 0 );
+	seenTwice.assign( 3 * N * W, 0 );
+	single.assign( 3 * N * W, 0 );
+	bandExcl.assign( N * W, 0 );
+	naked.reserve( N * N );
+
+	setPath( avx2Supported() ? AVX2 : SCALAR );
+}
+
+// =====================================================================
+// Dispatch
+// =====================================================================
+
+bool CandidateKernel::avx2Supported ( void )
+{
+#ifdef KERNEL_X86
+	return 4 % W == 0 && __builtin_cpu_supports( "avx2" );
+#else
+	return false;
+#endif
+}
+
+// Selects the primitives; AVX2 silently stays scalar when unsupported
+void CandidateKernel::setPath ( Path path )
+{
+	ops = path == AVX2 && avx2Supported() ? avx2Ops() : scalarOps();
+}
+
+CandidateKernel::Path CandidateKernel::getPath ( void ) const
+{
+	return ops == scalarOps() ? SCALAR : AVX2;
+}
+
+// =====================================================================
+// Kernel
+// =====================================================================
+
+const Word* CandidateKernel::unit ( const std::vector< Word >& v, int u ) const
+{
+	return v.data() + (std::size_t)u * W;
+}
+
+Word* CandidateKernel::unit ( std::vector< Word >& v, int u )
+{
+	return v.data() + (std::size_t)u * W;
+}
+
+// Unions the cell masks of src into every row, column and block
+void CandidateKernel::unionUnits ( const Word* src, std::vector< Word >& once, std::vector< Word >& twice )
+{
+	std::fill( once.begin(), once.end(), 0 );
+	std::fill( twice.begin(), twice.end(), 0 );
+
+	int rowWords = N * W;
+	for ( int r = 0; r < N; ++r )
+	{
+		const Word* row = src + (std::size_t)r * rowWords;
+
+		ops->reduce( unit( once, r ), unit( twice, r ), row, rowWords );
+		ops->accumulate( unit( once, N ), unit( twice, N ), row, rowWords );
+
+		for ( int bc = 0; bc < p; ++bc )
+		{
+			int b = 2 * N + r / p * p + bc;
+			ops->reduce( unit( once, b ), unit( twice, b ), row + bc * q * W, q * W );
+		}
+	}
+}
+
+bool CandidateKernel::run ( const NetworkState& state )
+{
+	int cells = N * N;
+	const Word* masks = state.mask( 0 );
+
+	// Placed values
+	for ( int c = 0; c < cells; ++c )
+	{
+		Word* a = assigned.data() + (std::size_t)c * W;
+		if ( state.hasFlag( c, NetworkState::ASSIGNED ) )
+			std::copy( masks + (std::size_t)c * W, masks + (std::size_t)( c + 1 ) * W, a );
+		else
+			std::fill( a, a + W, 0 );
+	}
+
+	unionUnits( assigned.data(), used, usedTwice );
+	for ( Word w : usedTwice )
+		if ( w != 0 )
+			return false;
+
+	// Candidates: mask minus everything placed in the row, column or block
+	int rowWords = N * W;
+	for ( int r = 0; r < N; ++r )
+	{
+		if ( r % p == 0 )
+			for ( int bc = 0; bc < p; ++bc )
+				ops->orPattern( bandExcl.data() + bc * q * W, unit( used, N ) + bc * q * W,
+				                unit( used, 2 * N + r + bc ), q * W );
+
+		ops->andNotPattern( cand.data() + (std::size_t)r * rowWords, masks + (std::size_t)r * rowWords,
+		                    bandExcl.data(), unit( used, r ), rowWords );
+	}
+
+	bool consistent = true;
+	for ( int c = 0; c < cells; ++c )
+	{
+		Word* m = cand.data() + (std::size_t)c * W;
+		if ( state.hasFlag( c, NetworkState::ASSIGNED ) )
+		{
+			std::copy( masks + (std::size_t)c * W, masks + (std::size_t)( c + 1 ) * W, m );
+			continue;
+		}
+
+		Word any = 0;
+		for ( int w = 0; w < W; ++w )
+			any |= m[w];
+
+		if ( any == 0 )
+			consistent = false;
+	}
+
+	return consistent;
+}
+
+void CandidateKernel::findSingles ( void )
+{
+	int cells = N * N;
+
+	naked.clear();
+	for ( int c = 0; c < cells; ++c )
+	{
+		const Word* m = cand.data() + (std::size_t)c * W;
+		const Word* a = assigned.data() + (std::size_t)c * W;
+
+		int size = 0;
+		bool open = true;
+		for ( int w = 0; w < W; ++w )
+		{
+			size += __builtin_popcountll( m[w] );
+			open = open && a[w] == 0;
+		}
+
+		if ( open && size == 1 )
+			naked.push_back( c );
+	}
+
+	// Hidden singles: candidate values seen exactly once and not yet placed
+	unionUnits( cand.data(), seen, seenTwice );
+	for ( std::size_t i = 0; i < single.size(); ++i )
+		single[i] = seen[i] & ~seenTwice[i] & ~used[i];
+}
+
+// =====================================================================
+// Results
+// =====================================================================
+
+const Word* CandidateKernel::candidates ( int cell ) const
+{
+	return unit( cand, cell );
+}
+
+const Word* CandidateKernel::placed ( int u ) const
+{
+	return unit( used, u );
+}
+
+const Word* CandidateKernel::hidden ( int u ) const
+{
+	return unit( single, u );
+}
+
+const std::vector< int >& CandidateKernel::nakedSingles ( void ) const
+{
+	return naked;
+}
@@ -0,0 +1,92 @@
+#ifndef CANDIDATEKERNEL_HPP
+#define CANDIDATEKERNEL_HPP
+
+#include "Domain.hpp"
+#include "NetworkState.hpp"
+
+#include <vector>
+
+/**
+ * Bulk candidate computation over a whole board.
+ *
+ * One run reads the masks of a NetworkState and, for every unit, builds
+ * the set of values already placed. From those it derives the candidate
+ * mask of every cell. On request, findSingles then derives the list of
+ * naked singles and, per unit, the values that fit exactly one open cell
+ * (hidden singles); forward checking needs neither, so run skips them.
+ *
+ * The kernel numbers its own 3N units: rows, then columns, then blocks.
+ * That matches ConstraintNetwork only when p and q are both above 1;
+ * otherwise the network drops the blocks that repeat a row or column.
+ * Unit numbers passed to placed() and hidden() are the kernel's.
+ *
+ * Rows, columns and block rows are all contiguous runs of masks in the
+ * state, so every pass is an element-wise OR / AND-NOT over a long word
+ * array. Those primitives have a scalar and an AVX2 version; the AVX2
+ * one is picked at runtime when the CPU supports it and the domain width
+ * packs evenly into a 256-bit register.
+ */
+
+class CandidateKernel
+{
+public:
+	// Typedefs
+	typedef Domain::Word Word;
+
+	enum Path { SCALAR, AVX2 };
+
+	// Table of primitives for one path, defined with them
+	struct Ops;
+
+	// Constructors
+	CandidateKernel ( void );
+	CandidateKernel ( int p, int q );
+
+	// Dispatch
+	static bool avx2Supported ( void );
+	void setPath ( Path path );
+	Path getPath ( void ) const;
+
+	// Computes the candidates of every cell of state. Returns false when
+	// two placed values clash or an open cell is left without candidates.
+	bool run ( const NetworkState& state );
+
+	// Fills nakedSingles and hidden from the last run, which must have
+	// returned true
+	void findSingles ( void );
+
+	// Results of the last run, and of findSingles
+	const Word* candidates ( int cell ) const;
+	const Word* placed     ( int unit ) const;
+	const Word* hidden     ( int unit ) const;
+	const std::vector< int >& nakedSingles ( void ) const;
+
+private:
+	const Word* unit ( const std::vector< Word >& v, int u ) const;
+	Word*       unit ( std::vector< Word >& v, int u );
+
+	void unionUnits ( const Word* src, std::vector< Word >& once, std::vector< Word >& twice );
+
+	int p = 0;
+	int q = 0;
+	int N = 0;
+	const Ops* ops = nullptr;
+
+	// Per cell: placed value bits (zero when open) and candidates
+	std::vector< Word > assigned;
+	std::vector< Word > cand;
+
+	// Per unit, keyed unit * WORDS
+	std::vector< Word > used;
+	std::vector< Word > usedTwice;
+	std::vector< Word > seen;
+	std::vector< Word > seenTwice;
+	std::vector< Word > single;
+
+	// One block row of column | block exclusions
+	std::vector< Word > bandExcl;
+
+	std::vector< int > naked;
+};
+
+#endif
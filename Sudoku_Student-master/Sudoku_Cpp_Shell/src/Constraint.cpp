@@ -20,13 +20,13 @@ void Constraint::addVariable ( Variable* v )
 	vars.push_back( v );
 }
 
-int Constraint::size ( void )
+int Constraint::size ( void ) const
 {
 	return vars.size();
 }
 
 // Returns true if v is in the constraint, false otherwise
-bool Constraint::contains ( Variable* v )
+bool Constraint::contains ( Variable* v ) const
 {
 	if ( std::find( vars.begin(), vars.end(), v ) != vars.end() )
 		return true;
@@ -35,7 +35,7 @@ bool Constraint::contains ( Variable* v )
 }
 
 // Returns whether or not the a variable in the constraint has been modified
-bool Constraint::isModified ( void )
+bool Constraint::isModified ( void ) const
 {
 	for ( Variable* var:vars )
 		if ( var->isModified() )
@@ -45,7 +45,7 @@ bool Constraint::isModified ( void )
 }
 
 // Returns true if constraint is consistent, false otherwise
-bool Constraint::isConsistent ( void )
+bool Constraint::isConsistent ( void ) const
 {
 	for ( Variable* var : vars )
 	{
@@ -30,10 +30,10 @@ public:
 	void addVariable ( Variable* v );
 
 	// Accessors
-	int  size         ( void );
-	bool contains     ( Variable* v );
-	bool isModified   ( void );
-	bool isConsistent ( void );
+	int  size         ( void ) const;
+	bool contains     ( Variable* v ) const;
+	bool isModified   ( void ) const;
+	bool isConsistent ( void ) const;
 
 	bool operator== ( const Constraint &other ) const;
 
@@ -15,35 +15,51 @@ ConstraintNetwork::ConstraintNetwork ( void )
 }
 
 ConstraintNetwork::ConstraintNetwork ( SudokuBoard sboard )
+: state( sboard.get_n() * sboard.get_n() )
 {
 	SudokuBoard::Board board = sboard.get_board();
 
 	VariableSet variables;
 	int value = 0;
 	int N = sboard.get_p() * sboard.get_q();
+	cells.reserve( N * N );
 
 	for ( int i = 0; i < N; ++i )
 	{
 		for ( int j = 0; j < N; ++j )
 		{
 			value = board[i][j];
-			std::vector<int> domain;
+			Domain domain;
 			if ( value == 0 )
 			{
 				for ( int d = 1; d <= N; ++d )
 				{
-					domain.push_back( d );
+					domain.add( d );
 				}
 			}
 			else
 			{
-				domain.push_back( value );
+				domain.add( value );
 			}
 
 			int block = ( i / sboard.get_p() * sboard.get_p() + j / sboard.get_q() );
+			int id = i * N + j;
 
-			Variable* toPushBack = new Variable(domain,i,j,block);
-			variables.push_back(toPushBack);
+			state.setMask( id, domain.bits() );
+			if ( domain.size() == 1 )
+			{
+				// Givens are fixed for the whole search
+				state.setFlag( id, NetworkState::ASSIGNED, true );
+				state.markModified( id );
+				state.setValue( id, *domain.begin() );
+			}
+			else
+			{
+				state.setFlag( id, NetworkState::CHANGEABLE, true );
+			}
+
+			cells.push_back( Variable( &state, id, i, j, block ) );
+			variables.push_back( &cells.back() );
 		}
 	}
 
@@ -109,6 +125,68 @@ ConstraintNetwork::ConstraintNetwork ( SudokuBoard sboard )
 		 }
 		 add( c );
 	  }
+
+	buildIndex();
+	attachState( N );
+}
+
+ConstraintNetwork::ConstraintNetwork ( const ConstraintNetwork& other )
+: constraints( other.constraints ), variables( other.variables ),
+  state( other.state ), cells( other.cells ),
+  indexed( other.indexed ), peerStart( other.peerStart ), peerList( other.peerList ),
+  unitStart( other.unitStart ), unitIds( other.unitIds )
+{
+	adopt( other );
+}
+
+ConstraintNetwork& ConstraintNetwork::operator= ( const ConstraintNetwork& other )
+{
+	if ( this == &other )
+		return *this;
+
+	constraints = other.constraints;
+	variables = other.variables;
+	state = other.state;
+	cells = other.cells;
+	indexed = other.indexed;
+	peerStart = other.peerStart;
+	peerList = other.peerList;
+	unitStart = other.unitStart;
+	unitIds = other.unitIds;
+	adopt( other );
+	return *this;
+}
+
+// Re-points copied handles and pointers from other's storage to our own
+void ConstraintNetwork::adopt ( const ConstraintNetwork& other )
+{
+	for ( Variable& v : cells )
+		v.rebind( &state );
+
+	for ( Variable*& v : variables )
+		v = own( v, other );
+
+	for ( Variable*& v : peerList )
+		v = own( v, other );
+
+	for ( Constraint& c : constraints )
+		for ( Variable*& v : c.vars )
+			v = own( v, other );
+
+	relinkUnits();
+}
+
+// Maps a variable owned by other onto the matching handle in this network
+Variable* ConstraintNetwork::own ( Variable* v, const ConstraintNetwork& other )
+{
+	if ( other.cells.empty() )
+		return v;
+
+	const Variable* first = &other.cells.front();
+	if ( v < first || v >= first + other.cells.size() )
+		return v;
+
+	return &cells[v - first];
 }
 
 // =====================================================================
@@ -119,6 +197,7 @@ void ConstraintNetwork::add ( Constraint c )
 {
 	if ( std::find(constraints.begin(),constraints.end(),c) == constraints.end()){
 		constraints.push_back( c );
+		indexed = false;
 	}
 }
 
@@ -127,6 +206,7 @@ void ConstraintNetwork::add ( Variable* v )
 	if ( std::find( variables.begin(), variables.end(), v ) == variables.end() )
 	{
 		variables.push_back( v );
+		indexed = false;
 	}
 }
 
@@ -134,38 +214,45 @@ void ConstraintNetwork::add ( Variable* v )
 // Accessors
 // =====================================================================
 
-ConstraintNetwork::ConstraintSet ConstraintNetwork::getConstraints ( void ) const
+const ConstraintNetwork::ConstraintSet& ConstraintNetwork::getConstraints ( void ) const
 {
 	return constraints;
 }
 
-ConstraintNetwork::VariableSet ConstraintNetwork::getVariables ( void ) const
+const ConstraintNetwork::VariableSet& ConstraintNetwork::getVariables ( void ) const
 {
 	return variables;
 }
 
+// Returns the cell storage behind the network's variables
+NetworkState& ConstraintNetwork::getState ( void )
+{
+	return state;
+}
+
+const NetworkState& ConstraintNetwork::getState ( void ) const
+{
+	return state;
+}
+
 // Returns all variables that share a constraint with v
-ConstraintNetwork::VariableSet ConstraintNetwork::getNeighborsOfVariable ( Variable* v )
+ConstraintNetwork::VariableSlice ConstraintNetwork::getNeighborsOfVariable ( Variable* v )
 {
-	ConstraintNetwork::VariableSet neighbors;
+	if ( ! indexed )
+		buildIndex();
 
-	for ( Constraint& c : constraints )
-	{
-		if ( c.contains( v ) )
-		{
-			for ( Variable* va : c.vars )
-				if ( va != v && std::find(neighbors.begin(),neighbors.end(),va) == neighbors.end() )
-					neighbors.push_back( va );
-		}
-	}
+	int i = v->index();
+	if ( i < 0 || i >= (int)variables.size() )
+		return VariableSlice( nullptr, nullptr );
 
-	return neighbors;
+	Variable* const* base = peerList.data();
+	return VariableSlice( base + peerStart[i], base + peerStart[i+1] );
 }
 
 // Returns true is every constraint is consistent
 bool ConstraintNetwork::isConsistent ( void ) const
 {
-	for ( Constraint c : constraints )
+	for ( const Constraint& c : constraints )
 		if ( ! c.isConsistent() )
 			return false;
 
@@ -173,15 +260,17 @@ bool ConstraintNetwork::isConsistent ( void ) const
 }
 
 // Returns a list of constraints that contains v
-ConstraintNetwork::ConstraintRefSet ConstraintNetwork::getConstraintsContainingVariable ( Variable* v )
+ConstraintNetwork::ConstraintSlice ConstraintNetwork::getConstraintsContainingVariable ( Variable* v )
 {
-	ConstraintNetwork::ConstraintRefSet outList;
+	if ( ! indexed )
+		buildIndex();
 
-	for ( Constraint& c : constraints )
-		if ( c.contains( v ) )
-			outList.push_back( &c );
+	int i = v->index();
+	if ( i < 0 || i >= (int)variables.size() )
+		return ConstraintSlice( nullptr, nullptr );
 
-	return outList;
+	Constraint* const* base = unitList.data();
+	return ConstraintSlice( base + unitStart[i], base + unitStart[i+1] );
 }
 
 /**
@@ -191,21 +280,124 @@ ConstraintNetwork::ConstraintRefSet ConstraintNetwork::getConstraintsContainingV
  * After getting the constraints, it will reset each variable to
  * unmodified.
  *
+ * The work is driven by the state's dirty list, so the cost depends on
+ * how many cells changed, not on the size of the network. Constraints
+ * come back in network order. The returned list is reused and stays
+ * valid until the next call.
+ *
  * Note* The first call to this method returns the constraints containing
  * the initialized variables.
  */
-ConstraintNetwork::ConstraintRefSet ConstraintNetwork::getModifiedConstraints ( void )
+const ConstraintNetwork::ConstraintRefSet& ConstraintNetwork::getModifiedConstraints ( void )
 {
-	ConstraintNetwork::ConstraintRefSet mConstraints;
+	if ( ! indexed )
+		buildIndex();
 
-	for ( Constraint& c : constraints )
-		if ( c.isModified() )
-			mConstraints.push_back( &c );
+	modifiedUnits.clear();
+	unitQueued.resize( constraints.size(), false );
 
-	for ( Variable* v : variables )
-		v->setModified( false );
+	for ( int cell : state.getDirtyCells() )
+	{
+		if ( ! state.hasFlag( cell, NetworkState::MODIFIED ) )
+			continue;
+
+		state.setFlag( cell, NetworkState::MODIFIED, false );
+
+		if ( cell >= (int)variables.size() )
+			continue;
 
-	return mConstraints;
+		for ( int k = unitStart[cell]; k < unitStart[cell+1]; ++k )
+		{
+			int u = unitIds[k];
+			if ( ! unitQueued[u] )
+			{
+				unitQueued[u] = true;
+				modifiedUnits.push_back( u );
+			}
+		}
+	}
+	state.clearDirtyCells();
+
+	std::sort( modifiedUnits.begin(), modifiedUnits.end() );
+
+	modifiedList.clear();
+	for ( int u : modifiedUnits )
+	{
+		unitQueued[u] = false;
+		modifiedList.push_back( &constraints[u] );
+	}
+
+	return modifiedList;
+}
+
+// =====================================================================
+// Peer and Unit Index
+// =====================================================================
+
+/**
+ * Builds the flat peer and unit tables. Peers keep the order the old
+ * constraint scan produced (constraint order, then variable order within
+ * the constraint, first occurrence wins) so heuristics see the same
+ * neighbor sequence.
+ */
+void ConstraintNetwork::buildIndex ( void )
+{
+	int n = variables.size();
+
+	std::vector< std::vector< int > > unitsOf( n );
+	for ( int ci = 0; ci < (int)constraints.size(); ++ci )
+		for ( Variable* v : constraints[ci].vars )
+			if ( v->index() >= 0 && v->index() < n )
+				unitsOf[v->index()].push_back( ci );
+
+	unitStart.assign( 1, 0 );
+	unitIds.clear();
+	peerStart.assign( 1, 0 );
+	peerList.clear();
+	std::vector< int > seenBy( n, -1 );
+
+	for ( int i = 0; i < n; ++i )
+	{
+		for ( int ci : unitsOf[i] )
+		{
+			unitIds.push_back( ci );
+
+			for ( Variable* va : constraints[ci].vars )
+			{
+				int j = va->index();
+				if ( j == i || j < 0 || j >= n || seenBy[j] == i )
+					continue;
+
+				seenBy[j] = i;
+				peerList.push_back( va );
+			}
+		}
+
+		unitStart.push_back( unitIds.size() );
+		peerStart.push_back( peerList.size() );
+	}
+
+	relinkUnits();
+	indexed = true;
+}
+
+// Hands the peer and unit layout to the state so it can maintain the
+// MRV index and per-unit value support
+void ConstraintNetwork::attachState ( int values )
+{
+	std::vector< int > peerIds( peerList.size() );
+	for ( int k = 0; k < (int)peerList.size(); ++k )
+		peerIds[k] = peerList[k]->index();
+	state.attachPeers( peerStart, peerIds );
+	state.attachUnits( constraints.size(), values, unitStart, unitIds );
+}
+
+// Points the unit table at this network's own constraint storage
+void ConstraintNetwork::relinkUnits ( void )
+{
+	unitList.resize( unitIds.size() );
+	for ( int k = 0; k < (int)unitIds.size(); ++k )
+		unitList[k] = &constraints[unitIds[k]];
 }
 
 // =====================================================================
@@ -5,6 +5,7 @@
 #include "Variable.hpp"
 #include "Constraint.hpp"
 #include "SudokuBoard.hpp"
+#include "NetworkState.hpp"
 
 #include <iostream>
 #include <string>
@@ -15,6 +16,28 @@
 #include <map>
 #include <utility>
 
+/**
+ * Read-only view over a contiguous run of elements owned by the network.
+ * Handing out slices lets hot lookups avoid building a new vector per call.
+ */
+template < typename T >
+class Slice
+{
+public:
+	Slice ( const T* first, const T* last ) : first( first ), last( last ) {}
+
+	const T* begin ( void ) const { return first; }
+	const T* end   ( void ) const { return last; }
+	int      size  ( void ) const { return last - first; }
+	bool     empty ( void ) const { return first == last; }
+
+	const T& operator[] ( int i ) const { return first[i]; }
+
+private:
+	const T* first;
+	const T* last;
+};
+
 class ConstraintNetwork
 {
 public:
@@ -22,33 +45,66 @@ public:
 	typedef typename std::vector< Constraint* > ConstraintRefSet;
 	typedef typename std::vector< Constraint > ConstraintSet;
 	typedef typename std::vector< Variable* > VariableSet;
+	typedef Slice< Variable* > VariableSlice;
+	typedef Slice< Constraint* > ConstraintSlice;
 
 
 	// Constructors
 	ConstraintNetwork ( void );
 	ConstraintNetwork ( SudokuBoard sboard );
+	ConstraintNetwork ( const ConstraintNetwork& other );
+
+	ConstraintNetwork& operator= ( const ConstraintNetwork& other );
 
 	// Modifiers
 	void add ( Constraint c );
 	void add ( Variable* v );
 
 	// Accessors
-	ConstraintSet getConstraints ( void ) const;
-	VariableSet   getVariables   ( void ) const;
+	const ConstraintSet& getConstraints ( void ) const;
+	const VariableSet&   getVariables   ( void ) const;
 
-	VariableSet getNeighborsOfVariable ( Variable* v );
+	VariableSlice getNeighborsOfVariable ( Variable* v );
 
 	bool isConsistent ( void ) const;
 
-	ConstraintRefSet getConstraintsContainingVariable ( Variable* v );
-	ConstraintRefSet getModifiedConstraints ( void );
+	NetworkState&       getState ( void );
+	const NetworkState& getState ( void ) const;
+
+	ConstraintSlice getConstraintsContainingVariable ( Variable* v );
+	const ConstraintRefSet& getModifiedConstraints ( void );
 
 	SudokuBoard toSudokuBoard ( int _p, int _q ) const;
 	std::string toString ( void ) const;
 
 private:
+	void buildIndex ( void );
+	void relinkUnits ( void );
+	void attachState ( int values );
+	void adopt ( const ConstraintNetwork& other );
+	Variable* own ( Variable* v, const ConstraintNetwork& other );
+
 	ConstraintSet constraints;
 	VariableSet variables;
+
+	// Cell storage owned by the network; variables point into cells
+	NetworkState state;
+	std::vector< Variable > cells;
+
+	// Peer and unit index, CSR layout: the peers of variable i are
+	// peerList[peerStart[i] .. peerStart[i+1]), likewise for units.
+	// Rebuilt lazily after the network is modified through add().
+	bool indexed = false;
+	std::vector< int > peerStart;
+	VariableSet peerList;
+	std::vector< int > unitStart;
+	std::vector< int > unitIds;
+	ConstraintRefSet unitList;
+
+	// Scratch space for getModifiedConstraints
+	std::vector< int > modifiedUnits;
+	std::vector< bool > unitQueued;
+	ConstraintRefSet modifiedList;
 };
 
 #endif
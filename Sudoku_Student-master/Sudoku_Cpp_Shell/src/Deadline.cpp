@@ -0,0 +1,127 @@
+#include "Deadline.hpp"
+
+#include <algorithm>
+
+constexpr std::chrono::microseconds Deadline::CHECK_PERIOD;
+
+// Bounds on the polls between clock readings
+static const long MIN_INTERVAL = 1;
+static const long MAX_INTERVAL = 1 << 16;
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+Deadline::Deadline ( void )
+{
+
+}
+
+// =====================================================================
+// Modifiers
+// =====================================================================
+
+void Deadline::set ( Clock::time_point at )
+{
+	deadline = at;
+	armed = true;
+	passed = false;
+
+	// Start by reading the clock at the first poll
+	interval = MIN_INTERVAL;
+	countdown = MIN_INTERVAL;
+	lastCheck = Clock::now();
+}
+
+// Sets the deadline milliseconds from now
+void Deadline::budget ( long milliseconds )
+{
+	set( Clock::now() + std::chrono::milliseconds( milliseconds ) );
+}
+
+void Deadline::clear ( void )
+{
+	armed = false;
+	passed = false;
+}
+
+// Makes poll() stop once *flag is true; nullptr detaches the flag
+void Deadline::setCancelFlag ( const std::atomic<bool>* flag )
+{
+	cancelFlag = flag;
+	stopped = false;
+}
+
+// =====================================================================
+// Accessors
+// =====================================================================
+
+bool Deadline::isSet ( void ) const
+{
+	return armed;
+}
+
+bool Deadline::expired ( void ) const
+{
+	return passed;
+}
+
+bool Deadline::cancelled ( void ) const
+{
+	return stopped;
+}
+
+Deadline::Clock::time_point Deadline::getTime ( void ) const
+{
+	return deadline;
+}
+
+long Deadline::getCheckInterval ( void ) const
+{
+	return interval;
+}
+
+// =====================================================================
+// Polling
+// =====================================================================
+
+bool Deadline::poll ( void )
+{
+	if ( passed || stopped )
+		return true;
+
+	if ( cancelFlag != nullptr && cancelFlag->load( std::memory_order_relaxed ) )
+	{
+		stopped = true;
+		return true;
+	}
+
+	if ( ! armed || --countdown > 0 )
+		return false;
+
+	return check();
+}
+
+// Reads the clock and rescales the interval to the measured node rate.
+// The interval at most doubles per reading, so a burst of cheap nodes
+// cannot push the next reading far past the deadline.
+bool Deadline::check ( void )
+{
+	Clock::time_point now = Clock::now();
+	if ( now >= deadline )
+	{
+		passed = true;
+		return true;
+	}
+
+	Clock::duration elapsed = now - lastCheck;
+	long scaled = interval * 2;
+	if ( elapsed.count() > 0 )
+		scaled = (long)( (double)interval * std::chrono::duration<double>( CHECK_PERIOD ).count()
+		                 / std::chrono::duration<double>( elapsed ).count() );
+
+	interval = std::max( MIN_INTERVAL, std::min( std::min( scaled, interval * 2 ), MAX_INTERVAL ) );
+	countdown = interval;
+	lastCheck = now;
+	return false;
+}
@@ -0,0 +1,69 @@
+#ifndef DEADLINE_HPP
+#define DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * Wall-clock deadline for a search, polled once per node.
+ *
+ * Reading the clock at every node costs more than a cheap node, so only
+ * every K-th poll looks at steady_clock. After each reading, K is scaled
+ * so that the next reading falls about CHECK_PERIOD later at the node
+ * rate just measured. The deadline is then overshot by roughly one
+ * period, however fast or slow the nodes are.
+ *
+ * An unset deadline never expires. Once expired, it stays expired until
+ * it is set again.
+ *
+ * A cancel flag, shared between threads, can also stop the search. It
+ * is a relaxed atomic load, so it is read at every poll.
+ */
+
+class Deadline
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	// Target time between two clock readings
+	static constexpr std::chrono::microseconds CHECK_PERIOD { 500 };
+
+	// Constructor
+	Deadline ( void );
+
+	// Modifiers
+	void set    ( Clock::time_point at );
+	void budget ( long milliseconds );
+	void clear  ( void );
+	void setCancelFlag ( const std::atomic<bool>* flag );
+
+	// Accessors
+	bool isSet     ( void ) const;
+	bool expired   ( void ) const;
+	bool cancelled ( void ) const;
+	Clock::time_point getTime ( void ) const;
+	long getCheckInterval ( void ) const;
+
+	// Counts one node and returns true once the deadline has passed or
+	// the search was cancelled
+	bool poll ( void );
+
+private:
+	bool check ( void );
+
+	// Properties
+	Clock::time_point deadline;
+	bool armed = false;
+	bool passed = false;
+
+	const std::atomic<bool>* cancelFlag = nullptr;
+	bool stopped = false;
+
+	// Polls between readings, polls left until the next one, and when
+	// the last reading was taken
+	long interval = 1;
+	long countdown = 1;
+	Clock::time_point lastCheck;
+};
+
+#endif
@@ -12,23 +12,33 @@
 // Constructs a domain with a single value
 Domain::Domain ( int value )
 {
-	values.push_back( value );
+	std::fill( values, values + WORDS, 0 );
+	modified = false;
+	add( value );
 }
 
 // Constructs a domain from a list of values
 Domain::Domain ( Domain::ValueSet vals )
 {
-	values = vals;
+	std::fill( values, values + WORDS, 0 );
+	modified = false;
+	for ( int v : vals )
+		add( v );
 }
 
-// Copy Constructor
-Domain::Domain ( const Domain& d )
+// Constructs a domain from a raw bitset of WORDS words
+Domain::Domain ( const Word* bits )
 {
-	values = d.values;
+	std::copy( bits, bits + WORDS, values );
+	modified = false;
 }
 
 // Default Constructor
-Domain::Domain (){};
+Domain::Domain ()
+{
+	std::fill( values, values + WORDS, 0 );
+	modified = false;
+}
 
 // =====================================================================
 // Accessors
@@ -36,27 +46,39 @@ Domain::Domain (){};
 
 Domain::ValueSet Domain::getValues ( void ) const
 {
-	return values;
+	ValueSet vals;
+	vals.reserve( size() );
+	for ( iterator it = begin(); it != end(); ++it )
+		vals.push_back( *it );
+	return vals;
 }
 
 // Checks if value exists within the domain
 bool Domain::contains ( int value ) const
 {
-	if ( std::find( values.begin(), values.end(), value ) != values.end() )
-		return true;
-	return false;
+	if ( value < 1 || value > MAX_VALUE )
+		return false;
+
+	int bit = value - 1;
+	return ( values[bit / WORD_BITS] >> ( bit % WORD_BITS ) ) & 1;
 }
 
 // Returns number of values in the domain
 int Domain::size ( void ) const
 {
-	return values.size();
+	int count = 0;
+	for ( int w = 0; w < WORDS; ++w )
+		count += __builtin_popcountll( values[w] );
+	return count;
 }
 
 // Returns true if no values are contained in the domain
 bool Domain::isEmpty ( void ) const
 {
-	return values.empty();
+	for ( int w = 0; w < WORDS; ++w )
+		if ( values[w] != 0 )
+			return false;
+	return true;
 }
 
 // Returns whether or not the domain has been modified
@@ -65,32 +87,40 @@ bool Domain::isModified ( void ) const
 	return modified;
 }
 
+// Returns true if both domains hold exactly the same values
 bool Domain::equals ( Domain d ) const
 {
-	return false;
+	return std::equal( values, values + WORDS, d.values );
+}
+
+// Returns the underlying bitset (WORDS words, value v in bit v-1)
+const Domain::Word* Domain::bits ( void ) const
+{
+	return values;
 }
 
 // =====================================================================
 // Modifiers
 // =====================================================================
 
-// Adds a value to the domain
+// Adds a value to the domain; a value past MAX_VALUE needs more DOMAIN_WORDS
 void Domain::add ( int value )
 {
-	if ( ! contains( value ) )
-		values.push_back( value );
+	assert( value >= 1 && value <= MAX_VALUE );
+
+	int bit = value - 1;
+	values[bit / WORD_BITS] |= Word(1) << ( bit % WORD_BITS );
 }
 
 // Remove a value from the domain
 bool Domain::remove ( int value )
 {
-	int v = value;
-
-	if ( std::find( values.begin(), values.end(), value ) == values.end() )
+	if ( ! contains( value ) )
 		return false;
 
+	int bit = value - 1;
 	setModified( true );
-	values.erase( std::remove( values.begin(), values.end(), value ), values.end() );
+	values[bit / WORD_BITS] &= ~( Word(1) << ( bit % WORD_BITS ) );
 	return true;
 }
 
@@ -104,14 +134,62 @@ void Domain::setModified ( bool modified )
 // Iterator
 // =====================================================================
 
-Domain::ValueSet::iterator Domain::begin()
+Domain::iterator Domain::begin() const
+{
+	return iterator( values, 0 );
+}
+
+Domain::iterator Domain::end() const
+{
+	return iterator( values, WORDS );
+}
+
+Domain::iterator::iterator ( const Word* _bits, int _word )
+{
+	bits = _bits;
+	word = _word;
+	rest = word < WORDS ? bits[word] : 0;
+	skipEmptyWords();
+}
+
+// Moves to the next word holding a value, or to the end position
+void Domain::iterator::skipEmptyWords ( void )
+{
+	while ( rest == 0 && word < WORDS )
+	{
+		++word;
+		rest = word < WORDS ? bits[word] : 0;
+	}
+}
+
+int Domain::iterator::operator* ( void ) const
+{
+	return word * WORD_BITS + __builtin_ctzll( rest ) + 1;
+}
+
+Domain::iterator& Domain::iterator::operator++ ( void )
+{
+	// Clear the lowest set bit
+	rest &= rest - 1;
+	skipEmptyWords();
+	return *this;
+}
+
+Domain::iterator Domain::iterator::operator++ ( int )
+{
+	iterator old = *this;
+	++( *this );
+	return old;
+}
+
+bool Domain::iterator::operator== ( const iterator& other ) const
 {
-	return values.begin();
+	return word == other.word && rest == other.rest;
 }
 
-Domain::ValueSet::iterator Domain::end()
+bool Domain::iterator::operator!= ( const iterator& other ) const
 {
-	return values.end();
+	return !( *this == other );
 }
 
 // =====================================================================
@@ -124,9 +202,9 @@ std::string Domain::toString( void ) const
 	ss << "{";
 	std::string delim = "";
 
-	for ( int i = 0; i < values.size(); ++i )
+	for ( iterator it = begin(); it != end(); ++it )
 	{
-		ss << delim << values[i];
+		ss << delim << *it;
 		delim = ",";
 	}
 
@@ -8,10 +8,22 @@
 #include <utility>
 #include <iostream>
 #include <algorithm>
+#include <cassert>
+
+// Number of 64-bit words per domain. The default of one covers every
+// board the parser accepts (N <= 64); build with -DDOMAIN_WORDS=2 or more
+// for larger boards.
+#ifndef DOMAIN_WORDS
+#define DOMAIN_WORDS 1
+#endif
 
 /**
  * Represents the domain of a variable, i.e. the possible values that each
  * variable may assign.
+ *
+ * Values are kept in a fixed bitset (value v lives in bit v-1), so
+ * contains, add and remove are O(1), size is a popcount and iteration
+ * walks the set bits from lowest to highest.
  */
 
 class Domain
@@ -19,12 +31,46 @@ class Domain
 public:
 	// Typedefs
 	typedef std::vector< int > ValueSet;
-	typedef ValueSet::iterator iterator;
+	typedef unsigned long long Word;
+
+	// Bitset geometry
+	static const int WORD_BITS = 64;
+	static const int WORDS     = DOMAIN_WORDS;
+	static const int MAX_VALUE = WORD_BITS * WORDS;
+
+	static_assert( WORDS >= 1, "DOMAIN_WORDS must be at least 1" );
+
+	// Iterates over the values of the domain in ascending order
+	class iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef int                     value_type;
+		typedef std::ptrdiff_t          difference_type;
+		typedef const int*              pointer;
+		typedef int                     reference;
+
+		iterator ( const Word* bits, int word );
+
+		int       operator*  ( void ) const;
+		iterator& operator++ ( void );
+		iterator  operator++ ( int );
+		bool      operator== ( const iterator& other ) const;
+		bool      operator!= ( const iterator& other ) const;
+
+	private:
+		void skipEmptyWords ( void );
+
+		const Word* bits;
+		int  word;
+		Word rest;
+	};
 
 	// Constructors
 	Domain ( int value );
 	Domain ( ValueSet values );
-	Domain ( const Domain& d );
+	Domain ( const Domain& d ) = default;
+	explicit Domain ( const Word* bits );
     Domain ();
 
 	// Accessors
@@ -34,22 +80,25 @@ public:
 	bool     isEmpty    ( void )      const;
 	bool     isModified ( void )      const;
 	bool     equals     ( Domain d )  const;
+	const Word* bits    ( void )      const;
+
+	Domain& operator= ( const Domain& d ) = default;
 
-	// Modifiers
+	// Modifiers; add requires 1 <= value <= MAX_VALUE
 	void add         ( int value );
 	bool remove      ( int value );
 	void setModified ( bool modified );
 
 	// Iterator
-	ValueSet::iterator begin();
-	ValueSet::iterator end();
+	iterator begin() const;
+	iterator end() const;
 
 	// String representation
 	std::string toString ( void ) const;
 
 private:
 	// Properties
-	ValueSet values;
+	Word values[WORDS];
 	bool modified;
 };
 
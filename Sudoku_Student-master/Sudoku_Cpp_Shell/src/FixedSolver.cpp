@@ -0,0 +1,41 @@
+#include "FixedSolver.hpp"
+
+/**
+ * Dispatch from a board's runtime p x q to the FixedSolver
+ * specialisation compiled for it.
+ */
+
+// =====================================================================
+// Dispatcher
+// =====================================================================
+
+template<int P, int Q>
+static bool runFixed ( const SudokuBoard& board, FixedResult& result )
+{
+	FixedSolver<P, Q> solver( board );
+	result.solved = solver.solve();
+	result.nodes = solver.getNodeCount();
+	if ( result.solved )
+		result.grid = solver.getSolution().view_board();
+	return true;
+}
+
+bool solveFixed ( const SudokuBoard& board, FixedResult& result )
+{
+	int p = board.get_p();
+	int q = board.get_q();
+
+	if ( p == 3 && q == 3 )
+		return runFixed<3, 3>( board, result );
+
+	if ( p == 3 && q == 4 )
+		return runFixed<3, 4>( board, result );
+
+	if ( p == 4 && q == 3 )
+		return runFixed<4, 3>( board, result );
+
+	if ( p == 4 && q == 4 )
+		return runFixed<4, 4>( board, result );
+
+	return false;
+}
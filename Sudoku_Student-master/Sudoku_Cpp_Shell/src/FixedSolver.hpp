@@ -0,0 +1,354 @@
+#ifndef FIXEDSOLVER_HPP
+#define FIXEDSOLVER_HPP
+
+#include "SudokuBoard.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Backtrack solver specialised at compile time for one board geometry.
+ *
+ * Block shape P x Q (so N = P * Q) is a template parameter, so every loop
+ * has a constant bound, the peer and unit tables are built by the
+ * compiler, and each candidate set is a single machine word just wide
+ * enough for N values (value v in bit v-1).
+ *
+ * The search is MRV with forward checking, naked singles and hidden
+ * singles run to a fixpoint after every assignment. Each level works on
+ * its own copy of the (small, flat) state, so backtracking is free.
+ *
+ * solveFixed() picks the specialisation for a board's p x q; other
+ * shapes are left to the generic BTSolver.
+ */
+
+// =====================================================================
+// Compile-time Layout
+// =====================================================================
+
+// Smallest unsigned word holding N candidate bits
+template<int N>
+struct FixedMask
+{
+	static_assert( N >= 1 && N <= 64, "FixedSolver supports N <= 64" );
+
+	typedef typename std::conditional< ( N <= 16 ), std::uint16_t,
+	        typename std::conditional< ( N <= 32 ), std::uint32_t,
+	                                   std::uint64_t >::type >::type type;
+};
+
+// Unit and peer tables of a P x Q block board. Units are the N rows,
+// then the N columns, then the N blocks, as in ConstraintNetwork.
+template<int P, int Q>
+struct FixedLayout
+{
+	static constexpr int N     = P * Q;
+	static constexpr int CELLS = N * N;
+	static constexpr int UNITS = 3 * N;
+	static constexpr int PEERS = 3 * ( N - 1 ) - ( P - 1 ) - ( Q - 1 );
+
+	int unitCells[UNITS][N];
+	int peers[CELLS][PEERS];
+
+	static constexpr int blockOf ( int row, int col )
+	{
+		return row / P * P + col / Q;
+	}
+
+	constexpr FixedLayout ( void ) : unitCells(), peers()
+	{
+		for ( int c = 0; c < CELLS; ++c )
+		{
+			int row = c / N;
+			int col = c % N;
+			int block = blockOf( row, col );
+
+			unitCells[row][col] = c;
+			unitCells[N + col][row] = c;
+			unitCells[2 * N + block][row % P * Q + col % Q] = c;
+
+			int k = 0;
+			for ( int o = 0; o < CELLS; ++o )
+				if ( o != c && ( o / N == row || o % N == col || blockOf( o / N, o % N ) == block ) )
+					peers[c][k++] = o;
+		}
+	}
+};
+
+// =====================================================================
+// Solver
+// =====================================================================
+
+template<int P, int Q>
+class FixedSolver
+{
+public:
+	typedef FixedLayout<P, Q> Layout;
+	typedef typename FixedMask<Layout::N>::type Mask;
+
+	static constexpr int N     = Layout::N;
+	static constexpr int CELLS = Layout::CELLS;
+	static constexpr int UNITS = Layout::UNITS;
+	static constexpr int PEERS = Layout::PEERS;
+	static constexpr Mask FULL = Mask( Mask( ~Mask(0) ) >> ( 8 * sizeof( Mask ) - N ) );
+
+	// Constructor
+	explicit FixedSolver ( const SudokuBoard& board );
+
+	// Engine Functions
+	bool solve ( void );
+
+	// Helper Functions
+	bool haveSolution ( void ) const;
+	SudokuBoard getSolution ( void ) const;
+	long getNodeCount ( void ) const;
+
+private:
+	// Flat search state; a cell is assigned once value is non-zero
+	struct State
+	{
+		Mask cand[CELLS];
+		unsigned char value[CELLS];
+	};
+
+	static constexpr Layout layout = Layout();
+
+	bool assign    ( State& s, int cell, int value ) const;
+	bool propagate ( State& s ) const;
+	bool search    ( const State& s );
+
+	State start;
+	State solution;
+	bool consistent = true;
+	bool hasSolution = false;
+	long numNodes = 0;
+};
+
+template<int P, int Q>
+constexpr typename FixedSolver<P, Q>::Layout FixedSolver<P, Q>::layout;
+
+// Result of running a board on its specialised engine
+struct FixedResult
+{
+	bool solved = false;
+	long nodes = 0;
+	SudokuBoard::Board grid;
+};
+
+// Solves board with the specialisation for its p x q. Returns false,
+// leaving result untouched, when the shape has no specialisation.
+bool solveFixed ( const SudokuBoard& board, FixedResult& result );
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+template<int P, int Q>
+FixedSolver<P, Q>::FixedSolver ( const SudokuBoard& board )
+{
+	SudokuBoard::Board grid = board.get_board();
+
+	for ( int c = 0; c < CELLS; ++c )
+	{
+		start.cand[c] = FULL;
+		start.value[c] = 0;
+	}
+
+	for ( int c = 0; c < CELLS && consistent; ++c )
+	{
+		int v = grid[c / N][c % N];
+		if ( v == 0 )
+			continue;
+
+		// Two givens clash when an earlier one already removed this value
+		if ( v > N || ! ( start.cand[c] >> ( v - 1 ) & 1 ) )
+			consistent = false;
+		else if ( ! assign( start, c, v ) )
+			consistent = false;
+	}
+
+	consistent = consistent && propagate( start );
+}
+
+// =====================================================================
+// Propagation
+// =====================================================================
+
+// Places value in cell and removes it from every peer. Peers left with
+// a single candidate are not placed here; propagate() picks them up.
+template<int P, int Q>
+bool FixedSolver<P, Q>::assign ( State& s, int cell, int value ) const
+{
+	Mask bit = Mask( Mask(1) << ( value - 1 ) );
+	s.value[cell] = (unsigned char)value;
+	s.cand[cell] = bit;
+
+	const int* peer = layout.peers[cell];
+	for ( int k = 0; k < PEERS; ++k )
+	{
+		Mask& m = s.cand[peer[k]];
+		if ( m & bit )
+		{
+			m &= Mask( ~bit );
+			if ( m == 0 )
+				return false;
+		}
+	}
+	return true;
+}
+
+// Runs naked and hidden singles until neither finds anything new
+template<int P, int Q>
+bool FixedSolver<P, Q>::propagate ( State& s ) const
+{
+	bool changed = true;
+	while ( changed )
+	{
+		changed = false;
+
+		// Naked singles
+		for ( int c = 0; c < CELLS; ++c )
+		{
+			if ( s.value[c] != 0 )
+				continue;
+
+			Mask m = s.cand[c];
+			if ( ( m & ( m - 1 ) ) == 0 )
+			{
+				if ( ! assign( s, c, __builtin_ctzll( m ) + 1 ) )
+					return false;
+				changed = true;
+			}
+		}
+
+		// Hidden singles: values seen exactly once in a unit
+		for ( int u = 0; u < UNITS; ++u )
+		{
+			const int* cells = layout.unitCells[u];
+			Mask once = 0;
+			Mask twice = 0;
+			for ( int k = 0; k < N; ++k )
+			{
+				Mask m = s.cand[cells[k]];
+				twice |= once & m;
+				once |= m;
+			}
+
+			if ( once != FULL )
+				return false;
+
+			Mask hidden = Mask( once & ~twice );
+			while ( hidden )
+			{
+				int bit = __builtin_ctzll( hidden );
+				hidden &= Mask( hidden - 1 );
+
+				for ( int k = 0; k < N; ++k )
+				{
+					int c = cells[k];
+					if ( s.cand[c] >> bit & 1 )
+					{
+						if ( s.value[c] == 0 )
+						{
+							if ( ! assign( s, c, bit + 1 ) )
+								return false;
+							changed = true;
+						}
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+// =====================================================================
+// Search
+// =====================================================================
+
+template<int P, int Q>
+bool FixedSolver<P, Q>::search ( const State& s )
+{
+	++numNodes;
+
+	// MRV: fewest candidates among unassigned cells, ties going to the
+	// cell with the most unassigned peers (as in MRVwithTieBreaker)
+	int best = -1;
+	int bestSize = N + 1;
+	int bestDegree = -1;
+	for ( int c = 0; c < CELLS; ++c )
+	{
+		if ( s.value[c] != 0 )
+			continue;
+
+		int size = __builtin_popcountll( s.cand[c] );
+		if ( size > bestSize )
+			continue;
+
+		int degree = 0;
+		const int* peer = layout.peers[c];
+		for ( int k = 0; k < PEERS; ++k )
+			degree += s.value[peer[k]] == 0;
+
+		if ( size < bestSize || degree > bestDegree )
+		{
+			best = c;
+			bestSize = size;
+			bestDegree = degree;
+		}
+	}
+
+	if ( best == -1 )
+	{
+		solution = s;
+		return true;
+	}
+
+	Mask rest = s.cand[best];
+	while ( rest )
+	{
+		int value = __builtin_ctzll( rest ) + 1;
+		rest &= Mask( rest - 1 );
+
+		State next = s;
+		if ( assign( next, best, value ) && propagate( next ) && search( next ) )
+			return true;
+	}
+	return false;
+}
+
+template<int P, int Q>
+bool FixedSolver<P, Q>::solve ( void )
+{
+	hasSolution = consistent && search( start );
+	return hasSolution;
+}
+
+// =====================================================================
+// Helper Functions
+// =====================================================================
+
+template<int P, int Q>
+bool FixedSolver<P, Q>::haveSolution ( void ) const
+{
+	return hasSolution;
+}
+
+template<int P, int Q>
+SudokuBoard FixedSolver<P, Q>::getSolution ( void ) const
+{
+	SudokuBoard::Board grid( N, SudokuBoard::Row( N, 0 ) );
+	for ( int c = 0; c < CELLS; ++c )
+		grid[c / N][c % N] = solution.value[c];
+	return SudokuBoard( P, Q, grid );
+}
+
+template<int P, int Q>
+long FixedSolver<P, Q>::getNodeCount ( void ) const
+{
+	return numNodes;
+}
+
+#endif
@@ -1,9 +1,17 @@
 #include "BTSolver.hpp"
+#include "FixedSolver.hpp"
+#include "Portfolio.hpp"
+#include "ParallelSearch.hpp"
+#include "BatchSolver.hpp"
+#include "BoardWriter.hpp"
+#include "Pipeline.hpp"
+#include "PuzzleFile.hpp"
 #include "SudokuBoard.hpp"
 #include "Trail.hpp"
 
 #include <iostream>
 #include <ctime>
+#include <chrono>
 #include <cmath>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -11,14 +19,69 @@
 #include <unistd.h>
 #include <time.h>
 #include <fstream>
+#include <thread>
 
 using namespace std;
 
 /**
  * Main driver file, which is responsible for interfacing with the
  * command line and properly starting the backtrack solver.
+ *
+ * -t <ms> gives every puzzle its own wall-clock budget. A puzzle that
+ * runs out of time is reported as timed out, not as unsolvable.
+ *
+ * PORTFOLIO races the default Portfolio configurations on threads, in
+ * place of the heuristics given, and reports which one won.
+ *
+ * -j <threads> searches each board with a work-stealing ParallelSearch
+ * over the heuristics given.
+ *
+ * -w <workers> solves a folder on a BatchSolver pool instead of board by
+ * board; the totals printed are the same.
+ *
+ * PIPELINE streams a folder through a Pipeline on -w workers (default:
+ * one per core), printing every board's result in folder order, then the
+ * totals and each stage's busy time and queue depth.
+ *
+ * A file of one-line puzzles (see PuzzleFile) is solved record by record
+ * on one Trail, as a folder is. Each result is printed, then the totals.
+ *
+ * Boards print in BoardWriter's PRETTY layout. COMPACT prints one line
+ * per board instead, and QUIET prints no boards, only the totals.
  */
 
+// Applies the -t budget, if any, and runs the solver
+static bool runSolver ( BTSolver& solver, bool iterative, long budget )
+{
+	if ( budget > 0 )
+		solver.setTimeBudget( budget );
+	return solver.run( iterative );
+}
+
+static string statusName ( PortfolioRun::Status status )
+{
+	switch ( status )
+	{
+		case PortfolioRun::SOLVED:     return "solved";
+		case PortfolioRun::UNSOLVABLE: return "unsolvable";
+		case PortfolioRun::TIMED_OUT:  return "timed out";
+		default:                       return "cancelled";
+	}
+}
+
+// Prints board in the writer's format, ahead of any later cout output
+static void printBoard ( BoardWriter& writer, const SudokuBoard& board )
+{
+	writer.write( board );
+	writer.flush();
+}
+
+static void printStage ( const string& name, const StageStats& stage )
+{
+	cout << name << ": " << stage.items << " items, " << stage.busySeconds * 1000.0 << " ms busy, queue depth "
+	     << stage.maxDepth << " max / " << stage.meanDepth << " mean" << endl;
+}
+
 int main ( int argc, char *argv[] )
 {
 	// Set random seed
@@ -29,6 +92,16 @@ int main ( int argc, char *argv[] )
 	string var_sh = "";
 	string val_sh = "";
 	string cc     = "";
+	Trail::Mode trailMode = Trail::DOMAIN_COPY;
+	bool fixed    = false;
+	int fishSize  = 0;
+	bool iterative = false;
+	long budget   = 0;
+	bool portfolio = false;
+	bool pipeline = false;
+	BoardWriter::Format format = BoardWriter::PRETTY;
+	int threads   = 0;
+	int workers   = 0;
 
 	for ( int i = 1; i < argc; ++i )
 	{
@@ -46,9 +119,15 @@ int main ( int argc, char *argv[] )
 		else if ( token == "FC" )
 			cc = "forwardChecking";
 
+		else if ( token == "IFC" )
+			cc = "incrementalForwardChecking";
+
 		else if ( token == "NOR" )
 			cc = "norvigCheck";
 
+		else if ( token == "GAC" )
+			cc = "generalizedArcConsistency";
+
 		else if ( token == "TOURN" )
 		{
 			 var_sh = "tournVar";
@@ -56,11 +135,52 @@ int main ( int argc, char *argv[] )
 			 cc     = "tournCC";
 		}
 
+		else if ( token == "DELTA" )
+			trailMode = Trail::DELTA;
+
+		else if ( token == "FIXED" )
+			fixed = true;
+
+		else if ( token == "FISH" )
+			fishSize = 4;
+
+		else if ( token == "ITER" )
+			iterative = true;
+
+		else if ( token == "PORTFOLIO" )
+			portfolio = true;
+
+		else if ( token == "PIPELINE" )
+			pipeline = true;
+
+		else if ( token == "COMPACT" )
+			format = BoardWriter::COMPACT;
+
+		else if ( token == "QUIET" )
+			format = BoardWriter::NONE;
+
+		else if ( token == "-w" && i + 1 < argc )
+			workers = atoi( argv[++i] );
+
+		else if ( token == "-j" && i + 1 < argc )
+			threads = atoi( argv[++i] );
+
+		else if ( token == "-t" && i + 1 < argc )
+			budget = atol( argv[++i] );
+
 		else
 			file = token;
 	}
 
-	Trail trail;
+	Trail trail( trailMode );
+	Portfolio racer( Portfolio::defaultConfigs(), trailMode );
+	vector<int> wins( racer.getConfigs().size(), 0 );
+
+	BatchSolver batch( val_sh, var_sh, cc, trailMode );
+	batch.setFishSize( fishSize );
+	batch.setIterative( iterative );
+	batch.setFixed( fixed );
+	batch.setTimeBudget( budget );
 
 	ofstream filewriter;
 	filewriter.open("timetaken.txt", std::ios_base::app);
@@ -78,23 +198,28 @@ int main ( int argc, char *argv[] )
 			cout << board.toString() << endl;
 
 			BTSolver solver = BTSolver( board, &trail, val_sh, var_sh, cc );
+			solver.setFishSize( fishSize );
 
 			//time measurement
 
 			clock_t t = clock();
 
-			if (cc == "forwardChecking" or cc == "norvigCheck" or cc == "tournCC")
-				solver.checkConsistency();
-			solver.solve(600.0);
+			runSolver( solver, iterative, budget );
 
 			if ( solver.haveSolution() )
 			{
 				cout << solver.getSolution().toString() << endl;
 				cout << "Trail Pushes: " << trail.getPushCount() << endl;
+				cout << "Stored Pushes: " << trail.getStoredPushCount() << endl;
 				trail.clear();
 				cout << "Backtracks: "  << trail.getUndoCount() << endl;
 			}
 
+			else if ( solver.timedOut() )
+			{
+				cout << "Timed out" << endl;
+			}
+
 			else
 			{
 				cout << "Failed to find a solution" << endl;
@@ -115,6 +240,49 @@ int main ( int argc, char *argv[] )
 	stat ( file.c_str(), &path_stat );
 	bool folder = S_ISDIR ( path_stat.st_mode );
 
+	if ( folder && ( workers > 0 || pipeline ) )
+	{
+		vector<string> paths = BatchSolver::listFolder( file );
+
+		if ( pipeline )
+		{
+			if ( workers <= 0 )
+				workers = max( 1u, thread::hardware_concurrency() );
+
+			Pipeline streamer( batch );
+			streamer.setFormat( format );
+			PipelineStats stats = streamer.run( paths, workers, cout );
+			const BatchTotals& totals = stats.totals;
+
+			cout << "Solutions Found: " << totals.solutions << endl;
+			cout << "Timed Out: " << totals.timeouts << endl;
+			cout << "Trail Pushes: " << totals.pushes << endl;
+			cout << "Stored Pushes: " << totals.stored << endl;
+			cout << "Backtracks: "  << totals.backtracks << endl;
+			if ( totals.malformed > 0 )
+				cout << "Malformed: " << totals.malformed << endl;
+			cout << "Boards/s: " << ( stats.seconds > 0.0 ? totals.boards / stats.seconds : 0.0 ) << endl;
+			printStage( "Parse", stats.parse );
+			printStage( "Solve", stats.solve );
+			printStage( "Emit", stats.emit );
+			return 0;
+		}
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		BatchTotals totals = batch.solve( paths, workers );
+		double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+		cout << "Solutions Found: " << totals.solutions << endl;
+		cout << "Timed Out: " << totals.timeouts << endl;
+		cout << "Trail Pushes: " << totals.pushes << endl;
+		cout << "Stored Pushes: " << totals.stored << endl;
+		cout << "Backtracks: "  << totals.backtracks << endl;
+		if ( totals.malformed > 0 )
+			cout << "Malformed: " << totals.malformed << endl;
+		cout << "Boards/s: " << ( seconds > 0.0 ? totals.boards / seconds : 0.0 ) << endl;
+		return 0;
+	}
+
 	if ( folder )
 	{
 		DIR *dir;
@@ -127,6 +295,7 @@ int main ( int argc, char *argv[] )
 		struct dirent *ent;
 
 		int numSolutions = 0;
+		int numTimeouts = 0;
 		while ( ( ent = readdir (dir) ) != NULL )
 		{
 			if ( ent->d_name[0] == '.' )
@@ -138,42 +307,204 @@ int main ( int argc, char *argv[] )
 
 
 			SudokuBoard board( individualFile );
+			if ( ! board.isValid() )
+			{
+				cout << "[ERROR] " << board.getError() << endl;
+				continue;
+			}
+
+			FixedResult result;
+			if ( fixed && solveFixed( board, result ) )
+			{
+				if ( result.solved )
+					numSolutions++;
+				continue;
+			}
+
+			if ( portfolio )
+			{
+				PortfolioResult outcome = racer.solve( board, budget );
+				if ( outcome.solved )
+					numSolutions++;
+				else if ( outcome.winner == -1 )
+					numTimeouts++;
+				if ( outcome.winner != -1 )
+					wins[outcome.winner]++;
+				continue;
+			}
+
+			if ( threads > 0 )
+			{
+				ParallelSearch search( board, val_sh, var_sh, cc, trailMode );
+				search.setFishSize( fishSize );
+				ParallelResult outcome = search.solve( threads, budget );
+				if ( outcome.solved )
+					numSolutions++;
+				else if ( outcome.timedOut )
+					numTimeouts++;
+				continue;
+			}
 
 			BTSolver solver = BTSolver( board, &trail, val_sh, var_sh, cc );
-			if (cc == "forwardChecking" or cc == "norvigCheck" or cc == "tournCC")
-	            solver.checkConsistency();
-			solver.solve(600.0);
+			solver.setFishSize( fishSize );
+			runSolver( solver, iterative, budget );
 
 			if ( solver.haveSolution() )
 				numSolutions++;
+			else if ( solver.timedOut() )
+				numTimeouts++;
 
 			trail.clear();
 		}
 
 		cout << "Solutions Found: " << numSolutions << endl;
-		cout << "Trail Pushes: " << trail.getPushCount() << endl;
-		cout << "Backtracks: "  << trail.getUndoCount() << endl;
+		cout << "Timed Out: " << numTimeouts << endl;
+		if ( portfolio )
+		{
+			for ( size_t k = 0; k < wins.size(); ++k )
+				cout << "Wins (" << racer.getConfigs()[k].name << "): " << wins[k] << endl;
+		}
+		else
+		{
+			cout << "Trail Pushes: " << trail.getPushCount() << endl;
+			cout << "Stored Pushes: " << trail.getStoredPushCount() << endl;
+			cout << "Backtracks: "  << trail.getUndoCount() << endl;
+		}
 		closedir (dir);
 
 		return 0;
 	}
 
+	PuzzleFile puzzles( file );
+	if ( puzzles.isLineFormat() )
+	{
+		BoardWriter writer( cout, format );
+		BatchTotals totals;
+		PuzzleRecord record;
+		ParseError error;
+		SudokuBoard::Board grid;
+		SudokuBoard::Board solution;
+		string name;
+		int p = 0;
+		int q = 0;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		while ( puzzles.next( record ) )
+		{
+			// Results are named file:line
+			name.assign( file ) += ':';
+			name += to_string( record.line );
+
+			if ( ! PuzzleFile::decode( record, p, q, grid, error ) )
+			{
+				writer.writeText( "[ERROR] " + name + ":" + to_string( error.column ) + ": " + error.message + "\n" );
+				totals.malformed++;
+				continue;
+			}
+
+			BatchSolver::Outcome outcome = batch.solveBoard( SudokuBoard( p, q, grid ), trail, totals, &solution );
+			trail.clear();
+
+			if ( outcome == BatchSolver::SOLVED )
+				writer.write( name, p, q, solution );
+			else if ( outcome == BatchSolver::TIMED_OUT )
+				writer.writeFailure( name, "Timed out" );
+			else
+				writer.writeFailure( name, "Failed to find a solution" );
+		}
+		writer.flush();
+		double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+		cout << "Puzzles: " << totals.boards << endl;
+		cout << "Solutions Found: " << totals.solutions << endl;
+		cout << "Timed Out: " << totals.timeouts << endl;
+		cout << "Malformed: " << totals.malformed << endl;
+		cout << "Trail Pushes: " << trail.getPushCount() << endl;
+		cout << "Stored Pushes: " << trail.getStoredPushCount() << endl;
+		cout << "Backtracks: "  << trail.getUndoCount() << endl;
+		cout << "Puzzles/s: " << ( seconds > 0.0 ? totals.boards / seconds : 0.0 ) << endl;
+		return 0;
+	}
+
 	SudokuBoard board( file );
-	cout << board.toString() << endl;
+	if ( ! board.isValid() )
+	{
+		cout << "[ERROR] " << board.getError() << endl;
+		return 0;
+	}
+
+	BoardWriter writer( cout, format );
+	printBoard( writer, board );
+
+	FixedResult result;
+	if ( fixed && solveFixed( board, result ) )
+	{
+		if ( result.solved )
+		{
+			printBoard( writer, SudokuBoard( board.get_p(), board.get_q(), result.grid ) );
+			cout << "Nodes: " << result.nodes << endl;
+		}
+		else
+		{
+			cout << "Failed to find a solution" << endl;
+		}
+		return 0;
+	}
+
+	if ( portfolio )
+	{
+		PortfolioResult outcome = racer.solve( board, budget );
+		if ( outcome.solved )
+			printBoard( writer, SudokuBoard( board.get_p(), board.get_q(), outcome.grid ) );
+		else if ( outcome.winner == -1 )
+			cout << "Timed out" << endl;
+		else
+			cout << "Failed to find a solution" << endl;
+
+		if ( outcome.winner != -1 )
+			cout << "Winner: " << racer.getConfigs()[outcome.winner].name << endl;
+		for ( size_t k = 0; k < outcome.runs.size(); ++k )
+			cout << racer.getConfigs()[k].name << ": " << statusName( outcome.runs[k].status )
+			     << ", " << outcome.runs[k].nodes << " nodes, "
+			     << outcome.runs[k].seconds * 1000.0 << " ms" << endl;
+		return 0;
+	}
+
+	if ( threads > 0 )
+	{
+		ParallelSearch search( board, val_sh, var_sh, cc, trailMode );
+		search.setFishSize( fishSize );
+		ParallelResult outcome = search.solve( threads, budget );
+		if ( outcome.solved )
+			printBoard( writer, SudokuBoard( board.get_p(), board.get_q(), outcome.grid ) );
+		else if ( outcome.timedOut )
+			cout << "Timed out" << endl;
+		else
+			cout << "Failed to find a solution" << endl;
+
+		cout << "Nodes: "  << outcome.nodes << endl;
+		cout << "Tasks: "  << outcome.tasks << endl;
+		cout << "Steals: " << outcome.steals << endl;
+		return 0;
+	}
 
 	//time measurement
 
 	BTSolver solver = BTSolver( board, &trail, val_sh, var_sh, cc );
-	if (cc == "forwardChecking" or cc == "norvigCheck" or cc == "tournCC")
-					solver.checkConsistency();
-	solver.solve(600.0);
+	solver.setFishSize( fishSize );
+	runSolver( solver, iterative, budget );
 
 	if ( solver.haveSolution() )
 	{
-		cout << solver.getSolution().toString() << endl;
+		printBoard( writer, solver.getSolution() );
 		cout << "Trail Pushes: " << trail.getPushCount() << endl;
+		cout << "Stored Pushes: " << trail.getStoredPushCount() << endl;
 		cout << "Backtracks: "  << trail.getUndoCount() << endl;
 	}
+	else if ( solver.timedOut() )
+	{
+		cout << "Timed out" << endl;
+	}
 	else
 	{
 		cout << "Failed to find a solution" << endl;
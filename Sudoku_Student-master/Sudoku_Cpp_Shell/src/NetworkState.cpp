@@ -0,0 +1,560 @@
+#include "NetworkState.hpp"
+
+#include <cstring>
+
+/**
+ * Compact, structure-of-arrays storage for the mutable search state of a
+ * constraint network.
+ */
+
+// =====================================================================
+// Constructors
+// =====================================================================
+
+NetworkState::NetworkState ( void )
+{
+	numCells = 0;
+	layout();
+}
+
+NetworkState::NetworkState ( int cells )
+{
+	numCells = cells;
+	layout();
+}
+
+NetworkState::NetworkState ( const NetworkState& other )
+{
+	copyFrom( other );
+}
+
+NetworkState& NetworkState::operator= ( const NetworkState& other )
+{
+	if ( this != &other )
+		copyFrom( other );
+	return *this;
+}
+
+// Copies everything, then re-carves the arrays over our own block
+void NetworkState::copyFrom ( const NetworkState& other )
+{
+	numCells = other.numCells;
+	layout();
+	storage = other.storage;
+	dirty = other.dirty;
+
+	numUnits = other.numUnits;
+	numValues = other.numValues;
+	cellUnitStart = other.cellUnitStart;
+	cellUnitIds = other.cellUnitIds;
+	supportCounts = other.supportCounts;
+	numBoardWords = other.numBoardWords;
+	digitBoards = other.digitBoards;
+	unitBoards = other.unitBoards;
+	supportEvents = other.supportEvents;
+	eventQueued = other.eventQueued;
+	eventHead = other.eventHead;
+
+	peersAttached = other.peersAttached;
+	maxDegree = other.maxDegree;
+	minKey = other.minKey;
+	minSize = other.minSize;
+	orderWords = other.orderWords;
+	indexedCells = other.indexedCells;
+	cellPeerStart = other.cellPeerStart;
+	cellPeerIds = other.cellPeerIds;
+	degree = other.degree;
+	orderKeyOf = other.orderKeyOf;
+	keyBoards = other.keyBoards;
+	keyCounts = other.keyCounts;
+	sizeBoards = other.sizeBoards;
+}
+
+// Sizes the backing block and carves it into the per-cell arrays
+void NetworkState::layout ( void )
+{
+	std::size_t maskWords  = (std::size_t)numCells * Domain::WORDS;
+	std::size_t valueWords = ( numCells * sizeof(int) + sizeof(Word) - 1 ) / sizeof(Word);
+	std::size_t flagWords  = ( numCells + sizeof(Word) - 1 ) / sizeof(Word);
+
+	storage.assign( maskWords + valueWords + flagWords, 0 );
+	dirty.clear();
+	dirty.reserve( numCells );
+
+	Word* base = storage.data();
+	masks  = base;
+	values = reinterpret_cast<int*>( base + maskWords );
+	flags  = reinterpret_cast<unsigned char*>( base + maskWords + valueWords );
+}
+
+// =====================================================================
+// Accessors
+// =====================================================================
+
+int NetworkState::cells ( void ) const
+{
+	return numCells;
+}
+
+const NetworkState::Word* NetworkState::mask ( int cell ) const
+{
+	return masks + (std::size_t)cell * Domain::WORDS;
+}
+
+int NetworkState::value ( int cell ) const
+{
+	return values[cell];
+}
+
+bool NetworkState::hasFlag ( int cell, unsigned char flag ) const
+{
+	return ( flags[cell] & flag ) != 0;
+}
+
+int NetworkState::domainSize ( int cell ) const
+{
+	const Word* bits = mask( cell );
+	int count = 0;
+	for ( int w = 0; w < Domain::WORDS; ++w )
+		count += __builtin_popcountll( bits[w] );
+	return count;
+}
+
+const std::vector< int >& NetworkState::getDirtyCells ( void ) const
+{
+	return dirty;
+}
+
+// Number of cells in unit that still hold value
+int NetworkState::supportCount ( int unit, int value ) const
+{
+	return supportCounts[unit * numValues + value - 1];
+}
+
+int NetworkState::boardWords ( void ) const
+{
+	return numBoardWords;
+}
+
+// Cells that still hold value
+const NetworkState::Word* NetworkState::digitBoard ( int value ) const
+{
+	return digitBoards.data() + (std::size_t)( value - 1 ) * numBoardWords;
+}
+
+// Cells of unit
+const NetworkState::Word* NetworkState::unitBoard ( int unit ) const
+{
+	return unitBoards.data() + (std::size_t)unit * numBoardWords;
+}
+
+// Returns the first cell of unit that still holds value, or -1
+int NetworkState::locate ( int unit, int value ) const
+{
+	const Word* digit = digitBoard( value );
+	const Word* cells = unitBoard( unit );
+
+	for ( int w = 0; w < numBoardWords; ++w )
+		if ( Word hit = digit[w] & cells[w] )
+			return w * Domain::WORD_BITS + __builtin_ctzll( hit );
+	return -1;
+}
+
+const int* NetworkState::cellUnits ( int cell ) const
+{
+	return cellUnitIds.data() + cellUnitStart[cell];
+}
+
+int NetworkState::cellUnitCount ( int cell ) const
+{
+	return cellUnitStart[cell+1] - cellUnitStart[cell];
+}
+
+// Returns the unassigned cell with the smallest domain, ties broken by
+// the most unassigned peers and then by the lowest cell, or -1 if every
+// cell is assigned
+int NetworkState::firstMinimumCell ( void )
+{
+	if ( indexedCells == 0 )
+		return -1;
+
+	while ( keyCounts[minKey] == 0 )
+		++minKey;
+
+	return lowestCell( keyBoards.data() + (std::size_t)minKey * orderWords, 0 );
+}
+
+// Returns the lowest-numbered unassigned cell with the smallest domain,
+// or -1 if every cell is assigned
+int NetworkState::firstSmallestCell ( void )
+{
+	if ( indexedCells == 0 )
+		return -1;
+
+	for ( ;; ++minSize )
+	{
+		int cell = lowestCell( sizeBoards.data() + (std::size_t)minSize * orderWords, 0 );
+		if ( cell != -1 )
+			return cell;
+	}
+}
+
+// Returns the next higher cell tied with cell in the MRV index, or -1
+int NetworkState::nextInBucket ( int cell ) const
+{
+	return lowestCell( keyBoards.data() + (std::size_t)orderKeyOf[cell] * orderWords, cell + 1 );
+}
+
+int NetworkState::unassignedDegree ( int cell ) const
+{
+	return degree[cell];
+}
+
+// =====================================================================
+// Modifiers
+// =====================================================================
+
+void NetworkState::setMask ( int cell, const Word* bits )
+{
+	Word* old = masks + (std::size_t)cell * Domain::WORDS;
+
+	if ( numValues > 0 )
+	{
+		for ( int w = 0; w < Domain::WORDS; ++w )
+		{
+			for ( Word gone = old[w] & ~bits[w]; gone; gone &= gone - 1 )
+				adjustSupport( cell, w * Domain::WORD_BITS + __builtin_ctzll( gone ) + 1, false );
+
+			for ( Word added = bits[w] & ~old[w]; added; added &= added - 1 )
+				adjustSupport( cell, w * Domain::WORD_BITS + __builtin_ctzll( added ) + 1, true );
+		}
+	}
+
+	std::memcpy( old, bits, sizeof(Word) * Domain::WORDS );
+
+	if ( peersAttached )
+		orderRekey( cell );
+}
+
+// Clears value from the cell's mask, returns false if it was not present
+bool NetworkState::removeValue ( int cell, int value )
+{
+	if ( value < 1 || value > Domain::MAX_VALUE )
+		return false;
+
+	int bit = value - 1;
+	Word& word = masks[(std::size_t)cell * Domain::WORDS + bit / Domain::WORD_BITS];
+	Word  b    = Word(1) << ( bit % Domain::WORD_BITS );
+
+	if ( ! ( word & b ) )
+		return false;
+
+	word &= ~b;
+
+	if ( numValues > 0 )
+		adjustSupport( cell, value, false );
+
+	if ( peersAttached )
+		orderRekey( cell );
+
+	return true;
+}
+
+void NetworkState::setValue ( int cell, int value )
+{
+	values[cell] = value;
+}
+
+void NetworkState::setFlag ( int cell, unsigned char flag, bool on )
+{
+	bool wasAssigned = flags[cell] & ASSIGNED;
+
+	if ( on )
+		flags[cell] |= flag;
+	else
+		flags[cell] &= ~flag;
+
+	bool isAssigned = flags[cell] & ASSIGNED;
+	if ( peersAttached && wasAssigned != isAssigned )
+		assignedChanged( cell, isAssigned );
+}
+
+// Raises MODIFIED and queues the cell on the dirty list if needed
+void NetworkState::markModified ( int cell )
+{
+	flags[cell] |= MODIFIED;
+
+	if ( ! ( flags[cell] & QUEUED ) )
+	{
+		flags[cell] |= QUEUED;
+		dirty.push_back( cell );
+	}
+}
+
+// Empties the dirty list; MODIFIED flags are left to the caller
+void NetworkState::clearDirtyCells ( void )
+{
+	for ( int cell : dirty )
+		flags[cell] &= ~QUEUED;
+	dirty.clear();
+}
+
+// =====================================================================
+// Unit Support
+// =====================================================================
+
+void NetworkState::attachUnits ( int units, int values, const std::vector< int >& unitStart,
+                                 const std::vector< int >& unitIds )
+{
+	numUnits = units;
+	numValues = std::min( values, (int)Domain::MAX_VALUE );
+	cellUnitStart = unitStart;
+	cellUnitIds = unitIds;
+
+	numBoardWords = ( numCells + Domain::WORD_BITS - 1 ) / Domain::WORD_BITS;
+	unitBoards.assign( (std::size_t)numUnits * numBoardWords, 0 );
+	for ( int cell = 0; cell < numCells; ++cell )
+		for ( int k = cellUnitStart[cell]; k < cellUnitStart[cell+1]; ++k )
+			unitBoards[(std::size_t)cellUnitIds[k] * numBoardWords + cell / Domain::WORD_BITS]
+				|= Word(1) << ( cell % Domain::WORD_BITS );
+
+	rebuildSupport();
+}
+
+// Recounts support from the current masks and queues every weak pair
+void NetworkState::rebuildSupport ( void )
+{
+	std::size_t keys = (std::size_t)numUnits * numValues;
+	supportCounts.assign( keys, 0 );
+	digitBoards.assign( (std::size_t)numValues * numBoardWords, 0 );
+	supportEvents.clear();
+	eventQueued.assign( keys, 0 );
+	eventHead = 0;
+
+	if ( numValues == 0 )
+		return;
+
+	for ( int cell = 0; cell < numCells; ++cell )
+	{
+		const Word* bits = mask( cell );
+		for ( int w = 0; w < Domain::WORDS; ++w )
+			for ( Word b = bits[w]; b; b &= b - 1 )
+				adjustSupport( cell, w * Domain::WORD_BITS + __builtin_ctzll( b ) + 1, true );
+	}
+
+	for ( std::size_t key = 0; key < keys; ++key )
+	{
+		if ( supportCounts[key] <= 1 )
+		{
+			eventQueued[key] = 1;
+			supportEvents.push_back( key );
+		}
+	}
+}
+
+// Adds or removes the cell from value's bitboard and its support for
+// value in each of its units
+void NetworkState::adjustSupport ( int cell, int value, bool added )
+{
+	if ( value > numValues )
+		return;
+
+	Word& word = digitBoards[(std::size_t)( value - 1 ) * numBoardWords + cell / Domain::WORD_BITS];
+	Word  b    = Word(1) << ( cell % Domain::WORD_BITS );
+
+	if ( added )
+		word |= b;
+	else
+		word &= ~b;
+
+	for ( int k = cellUnitStart[cell]; k < cellUnitStart[cell+1]; ++k )
+	{
+		int key = cellUnitIds[k] * numValues + value - 1;
+
+		if ( added )
+		{
+			supportCounts[key]++;
+			continue;
+		}
+
+		supportCounts[key]--;
+
+		if ( supportCounts[key] <= 1 && ! eventQueued[key] )
+		{
+			eventQueued[key] = 1;
+			supportEvents.push_back( key );
+		}
+	}
+}
+
+bool NetworkState::nextSupportEvent ( int& unit, int& value )
+{
+	if ( eventHead == supportEvents.size() )
+	{
+		supportEvents.clear();
+		eventHead = 0;
+		return false;
+	}
+
+	int key = supportEvents[eventHead++];
+	eventQueued[key] = 0;
+	unit  = key / numValues;
+	value = key % numValues + 1;
+	return true;
+}
+
+// =====================================================================
+// MRV Index
+// =====================================================================
+
+void NetworkState::attachPeers ( const std::vector< int >& peerStart, const std::vector< int >& peerIds )
+{
+	cellPeerStart = peerStart;
+	cellPeerIds = peerIds;
+	peersAttached = true;
+	rebuildOrder();
+}
+
+// Recomputes degrees and re-files every unassigned cell
+void NetworkState::rebuildOrder ( void )
+{
+	if ( ! peersAttached )
+		return;
+
+	maxDegree = 0;
+	for ( int cell = 0; cell < numCells; ++cell )
+		maxDegree = std::max( maxDegree, cellPeerStart[cell+1] - cellPeerStart[cell] );
+
+	int maxSize = numValues > 0 ? numValues : Domain::MAX_VALUE;
+	int keys = ( maxSize + 1 ) * ( maxDegree + 1 );
+	orderWords = ( numCells + Domain::WORD_BITS - 1 ) / Domain::WORD_BITS;
+	orderKeyOf.assign( numCells, -1 );
+	degree.assign( numCells, 0 );
+	keyBoards.assign( (std::size_t)keys * orderWords, 0 );
+	keyCounts.assign( keys, 0 );
+	minKey = keys - 1;
+
+	sizeBoards.assign( (std::size_t)( maxSize + 1 ) * orderWords, 0 );
+	minSize = maxSize;
+	indexedCells = 0;
+
+	for ( int cell = 0; cell < numCells; ++cell )
+		for ( int k = cellPeerStart[cell]; k < cellPeerStart[cell+1]; ++k )
+			if ( ! ( flags[cellPeerIds[k]] & ASSIGNED ) )
+				degree[cell]++;
+
+	for ( int cell = 0; cell < numCells; ++cell )
+		if ( ! ( flags[cell] & ASSIGNED ) )
+			orderInsert( cell );
+}
+
+// Smaller domains first, then more unassigned peers first
+int NetworkState::orderKey ( int cell ) const
+{
+	return domainSize( cell ) * ( maxDegree + 1 ) + ( maxDegree - degree[cell] );
+}
+
+// Lowest cell at or after from on board, or -1
+int NetworkState::lowestCell ( const Word* board, int from ) const
+{
+	int w = from / Domain::WORD_BITS;
+	if ( w >= orderWords )
+		return -1;
+
+	Word bits = board[w] & ( ~Word(0) << ( from % Domain::WORD_BITS ) );
+	while ( bits == 0 )
+	{
+		if ( ++w == orderWords )
+			return -1;
+		bits = board[w];
+	}
+	return w * Domain::WORD_BITS + __builtin_ctzll( bits );
+}
+
+void NetworkState::orderInsert ( int cell )
+{
+	int key = orderKey( cell );
+	Word bit = Word(1) << ( cell % Domain::WORD_BITS );
+
+	orderKeyOf[cell] = key;
+	keyBoards[(std::size_t)key * orderWords + cell / Domain::WORD_BITS] |= bit;
+	keyCounts[key]++;
+
+	if ( key < minKey )
+		minKey = key;
+
+	int size = key / ( maxDegree + 1 );
+	sizeBoards[(std::size_t)size * orderWords + cell / Domain::WORD_BITS] |= bit;
+	if ( size < minSize )
+		minSize = size;
+	indexedCells++;
+}
+
+void NetworkState::orderErase ( int cell )
+{
+	int key = orderKeyOf[cell];
+	Word bit = Word(1) << ( cell % Domain::WORD_BITS );
+
+	keyBoards[(std::size_t)key * orderWords + cell / Domain::WORD_BITS] &= ~bit;
+	keyCounts[key]--;
+
+	int size = key / ( maxDegree + 1 );
+	sizeBoards[(std::size_t)size * orderWords + cell / Domain::WORD_BITS] &= ~bit;
+
+	orderKeyOf[cell] = -1;
+	indexedCells--;
+}
+
+// Moves an indexed cell to the board matching its current key
+void NetworkState::orderRekey ( int cell )
+{
+	if ( orderKeyOf[cell] == -1 || orderKeyOf[cell] == orderKey( cell ) )
+		return;
+
+	orderErase( cell );
+	orderInsert( cell );
+}
+
+// Keeps the index and the peers' degrees in step with an (un)assignment
+void NetworkState::assignedChanged ( int cell, bool assigned )
+{
+	if ( assigned && orderKeyOf[cell] != -1 )
+		orderErase( cell );
+
+	for ( int k = cellPeerStart[cell]; k < cellPeerStart[cell+1]; ++k )
+	{
+		int peer = cellPeerIds[k];
+		degree[peer] += assigned ? -1 : 1;
+		orderRekey( peer );
+	}
+
+	if ( ! assigned )
+		orderInsert( cell );
+}
+
+// =====================================================================
+// Snapshots
+// =====================================================================
+
+std::size_t NetworkState::snapshotBytes ( void ) const
+{
+	return storage.size() * sizeof(Word);
+}
+
+void NetworkState::saveSnapshot ( void* out ) const
+{
+	std::memcpy( out, storage.data(), snapshotBytes() );
+}
+
+void NetworkState::loadSnapshot ( const void* in )
+{
+	std::memcpy( storage.data(), in, snapshotBytes() );
+
+	dirty.clear();
+	for ( int cell = 0; cell < numCells; ++cell )
+		if ( flags[cell] & QUEUED )
+			dirty.push_back( cell );
+
+	rebuildSupport();
+	rebuildOrder();
+}
@@ -0,0 +1,168 @@
+#ifndef NETWORKSTATE_HPP
+#define NETWORKSTATE_HPP
+
+#include "Domain.hpp"
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Compact, structure-of-arrays storage for the mutable search state of a
+ * constraint network: one domain mask, one assigned value and one flag
+ * byte per cell, all indexed by cell id.
+ *
+ * Everything lives in a single contiguous block, so the full search
+ * state can be snapshotted and restored with one memcpy.
+ *
+ * Cells whose MODIFIED flag is raised are also appended to a dirty list
+ * (at most once until it is drained), so consumers of modifications only
+ * pay for what actually changed.
+ *
+ * Once the unit layout is attached, the state also keeps one bitboard
+ * per value, marking every cell that still holds it, and one bitboard
+ * per unit, marking its cells. The cells of a unit that can take a value
+ * are then one AND away. Alongside, every (unit, value) pair keeps a
+ * count of those cells. Every mask write updates both, so undoing a
+ * domain change through the trail restores them too. A pair whose
+ * support drops to one (or zero) is queued as a support event, which is
+ * what hidden-single detection consumes.
+ *
+ * Once the peer layout is attached, unassigned cells are also kept in an
+ * MRV index: one bitboard of cells per key (domain size ascending,
+ * unassigned-peer degree descending), plus one per domain size. Mask and
+ * ASSIGNED changes move cells between boards, so the trail restores the
+ * index for free. The MRV / degree pick is the lowest cell of the lowest
+ * non-empty key board, and the plain MRV pick the lowest cell of the
+ * lowest non-empty size board; either way ties go in cell order, as a
+ * row-major scan would take them, whatever the order of the writes.
+ */
+
+class NetworkState
+{
+public:
+	// Typedefs
+	typedef Domain::Word Word;
+
+	// Flag bits
+	static const unsigned char MODIFIED   = 1;
+	static const unsigned char CHANGEABLE = 2;
+	static const unsigned char ASSIGNED   = 4;
+	static const unsigned char QUEUED     = 8;
+
+	// Constructors
+	NetworkState ( void );
+	NetworkState ( int cells );
+	NetworkState ( const NetworkState& other );
+
+	NetworkState& operator= ( const NetworkState& other );
+
+	// Accessors
+	int cells ( void ) const;
+
+	const Word* mask   ( int cell ) const;
+	int         value  ( int cell ) const;
+	bool        hasFlag ( int cell, unsigned char flag ) const;
+	int         domainSize ( int cell ) const;
+
+	const std::vector< int >& getDirtyCells ( void ) const;
+
+	int         supportCount ( int unit, int value ) const;
+
+	// Bitboards over cells (cell c in bit c), boardWords() words each
+	int         boardWords ( void ) const;
+	const Word* digitBoard ( int value ) const;
+	const Word* unitBoard  ( int unit ) const;
+	int         locate     ( int unit, int value ) const;
+
+	// Units holding cell: cellUnits( cell )[0 .. cellUnitCount( cell ))
+	const int*  cellUnits     ( int cell ) const;
+	int         cellUnitCount ( int cell ) const;
+
+	// MRV index: lowest cell of the best key (firstMinimumCell) or of the
+	// smallest size (firstSmallestCell), -1 once all are assigned
+	int firstMinimumCell ( void );
+	int firstSmallestCell ( void );
+	int nextInBucket     ( int cell ) const;
+	int unassignedDegree ( int cell ) const;
+
+	// Modifiers
+	void setMask  ( int cell, const Word* bits );
+	bool removeValue ( int cell, int value );
+	void setValue ( int cell, int value );
+	void setFlag  ( int cell, unsigned char flag, bool on );
+	void markModified ( int cell );
+	void clearDirtyCells ( void );
+
+	// Unit layout: units of cell c are unitIds[unitStart[c] .. unitStart[c+1])
+	void attachUnits ( int units, int values, const std::vector< int >& unitStart,
+	                   const std::vector< int >& unitIds );
+
+	// Pops the next (unit, value) whose support dropped to one or zero
+	bool nextSupportEvent ( int& unit, int& value );
+
+	// Peer layout: peers of cell c are peerIds[peerStart[c] .. peerStart[c+1])
+	void attachPeers ( const std::vector< int >& peerStart, const std::vector< int >& peerIds );
+
+	// Snapshots
+	std::size_t snapshotBytes ( void ) const;
+	void saveSnapshot ( void* out ) const;
+	void loadSnapshot ( const void* in );
+
+private:
+	void layout ( void );
+	void copyFrom ( const NetworkState& other );
+	void rebuildSupport ( void );
+	void adjustSupport ( int cell, int value, bool added );
+	void rebuildOrder ( void );
+	int  orderKey ( int cell ) const;
+	int  lowestCell ( const Word* board, int from ) const;
+	void orderInsert ( int cell );
+	void orderErase ( int cell );
+	void orderRekey ( int cell );
+	void assignedChanged ( int cell, bool assigned );
+
+	int numCells;
+
+	// Single block: masks | values | flags
+	std::vector< Word > storage;
+	Word* masks;
+	int* values;
+	unsigned char* flags;
+
+	// Cells with QUEUED set, in the order they were first modified
+	std::vector< int > dirty;
+
+	// Unit layout and per-(unit, value) support, keyed unit * numValues + value - 1
+	int numUnits = 0;
+	int numValues = 0;
+	std::vector< int > cellUnitStart;
+	std::vector< int > cellUnitIds;
+	std::vector< int > supportCounts;
+
+	// Bitboards, keyed value - 1 and unit, numBoardWords words each
+	int numBoardWords = 0;
+	std::vector< Word > digitBoards;
+	std::vector< Word > unitBoards;
+	std::vector< int > supportEvents;
+	std::vector< char > eventQueued;
+	std::size_t eventHead = 0;
+
+	// Peer layout and MRV index; orderKeyOf is -1 for cells not indexed.
+	// keyBoards holds orderWords words per key, keyCounts its cells, and
+	// sizeBoards orderWords words per domain size.
+	bool peersAttached = false;
+	int maxDegree = 0;
+	int minKey = 0;
+	int minSize = 0;
+	int orderWords = 0;
+	int indexedCells = 0;
+	std::vector< int > cellPeerStart;
+	std::vector< int > cellPeerIds;
+	std::vector< int > degree;
+	std::vector< int > orderKeyOf;
+	std::vector< Word > keyBoards;
+	std::vector< int > keyCounts;
+	std::vector< Word > sizeBoards;
+};
+
+#endif
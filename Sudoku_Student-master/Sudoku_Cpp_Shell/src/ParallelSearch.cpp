@@ -0,0 +1,217 @@
+#include "ParallelSearch.hpp"
+#include "BTSolver.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * Work-stealing parallel tree search; see ParallelSearch.hpp.
+ */
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+ParallelSearch::ParallelSearch ( const SudokuBoard& _board, std::string val_sh, std::string var_sh, std::string cc,
+                                 Trail::Mode _trailMode )
+: board( _board.get_p(), _board.get_q(), _board.get_board() ), pending( 0 ), stop( false ), found( false )
+{
+	valHeuristics = val_sh;
+	varHeuristics = var_sh;
+	cChecks = cc;
+	trailMode = _trailMode;
+}
+
+// =====================================================================
+// Modifiers
+// =====================================================================
+
+void ParallelSearch::setFishSize ( int size )
+{
+	fishSize = size;
+}
+
+void ParallelSearch::setSplitDepth ( int depth )
+{
+	splitDepth = std::max( 0, depth );
+}
+
+// =====================================================================
+// Search
+// =====================================================================
+
+ParallelResult ParallelSearch::solve ( int threads, long budget )
+{
+	ParallelResult result;
+
+	numThreads = std::max( 1, threads );
+	queues.clear();
+	for ( int i = 0; i < numThreads; ++i )
+		queues.emplace_back( new TaskQueue() );
+	pending.store( 0 );
+	stop.store( false );
+	found.store( false );
+	deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( budget );
+
+	// The root task is the state after the initial check
+	Trail trail( trailMode );
+	BTSolver root( board, &trail, valHeuristics, varHeuristics, cChecks );
+	root.setFishSize( fishSize );
+	if ( ! root.initialCheck() )
+		return result;
+
+	Task task;
+	task.state.resize( root.stateBytes() );
+	task.depth = 0;
+	root.saveState( task.state.data() );
+	queues[0]->tasks.push_back( std::move( task ) );
+	pending.store( 1 );
+
+	std::vector<WorkerStats> stats( numThreads );
+	std::vector<std::thread> workers;
+	workers.reserve( numThreads );
+	for ( int i = 0; i < numThreads; ++i )
+		workers.emplace_back( &ParallelSearch::work, this, i, budget > 0, std::ref( stats[i] ) );
+
+	for ( std::thread& t : workers )
+		t.join();
+
+	result.solved = found.load();
+	if ( result.solved )
+		result.grid = solution;
+
+	for ( const WorkerStats& s : stats )
+	{
+		result.nodes += s.nodes;
+		result.tasks += s.tasks;
+		result.steals += s.steals;
+		result.timedOut = result.timedOut || s.timedOut;
+	}
+	result.timedOut = result.timedOut && ! result.solved;
+	return result;
+}
+
+void ParallelSearch::work ( int self, bool timed, WorkerStats& stats )
+{
+	Trail trail( trailMode );
+	BTSolver solver( board, &trail, valHeuristics, varHeuristics, cChecks );
+	solver.setFishSize( fishSize );
+	solver.setCancelFlag( &stop );
+	if ( timed )
+		solver.setDeadline( deadline );
+
+	long expanded = 0;
+	Task task;
+	while ( ! stop.load( std::memory_order_relaxed ) )
+	{
+		if ( ! take( self, task, stats ) )
+		{
+			if ( pending.load() == 0 )
+				break;
+			std::this_thread::yield();
+			continue;
+		}
+
+		stats.tasks++;
+		solver.loadState( task.state.data() );
+
+		if ( task.depth < splitDepth && pending.load() < (long)SPLIT_LIMIT * numThreads )
+		{
+			expand( self, solver, task );
+			expanded++;
+		}
+		else
+		{
+			solver.solveIterative();
+			if ( solver.haveSolution() )
+				claim( solver );
+			else if ( solver.timedOut() )
+			{
+				stats.timedOut = true;
+				stop.store( true );
+			}
+		}
+
+		pending.fetch_sub( 1 );
+	}
+
+	stats.nodes = solver.getNodeCount() + expanded;
+}
+
+// Pops from the back of the worker's own deque, or else steals from the
+// front of another's
+bool ParallelSearch::take ( int self, Task& task, WorkerStats& stats )
+{
+	{
+		TaskQueue& own = *queues[self];
+		std::lock_guard<std::mutex> guard( own.lock );
+		if ( ! own.tasks.empty() )
+		{
+			task = std::move( own.tasks.back() );
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for ( int k = 1; k < numThreads; ++k )
+	{
+		TaskQueue& victim = *queues[( self + k ) % numThreads];
+		std::lock_guard<std::mutex> guard( victim.lock );
+		if ( ! victim.tasks.empty() )
+		{
+			task = std::move( victim.tasks.front() );
+			victim.tasks.pop_front();
+			stats.steals++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Turns every consistent child of the task's node into a task. They are
+// pushed last value first, so the owner still tries values in order.
+void ParallelSearch::expand ( int self, BTSolver& solver, const Task& task )
+{
+	Variable* v = solver.selectNextVariable();
+	if ( v == nullptr )
+	{
+		if ( solver.isComplete() )
+			claim( solver );
+		return;
+	}
+
+	std::vector<Task> children;
+	for ( int value : solver.getNextValues( v ) )
+	{
+		if ( solver.decide( v, value ) )
+		{
+			Task child;
+			child.state.resize( solver.stateBytes() );
+			child.depth = task.depth + 1;
+			solver.saveState( child.state.data() );
+			children.push_back( std::move( child ) );
+		}
+		solver.undoDecision();
+	}
+
+	// Counted before the parent is retired, so pending never reads zero
+	// while work remains
+	pending.fetch_add( children.size() );
+
+	TaskQueue& own = *queues[self];
+	std::lock_guard<std::mutex> guard( own.lock );
+	for ( auto child = children.rbegin(); child != children.rend(); ++child )
+		own.tasks.push_back( std::move( *child ) );
+}
+
+// Records the first solution found and stops every worker
+void ParallelSearch::claim ( BTSolver& solver )
+{
+	bool none = false;
+	if ( found.compare_exchange_strong( none, true ) )
+	{
+		solution = solver.getSolution().view_board();
+		stop.store( true );
+	}
+}
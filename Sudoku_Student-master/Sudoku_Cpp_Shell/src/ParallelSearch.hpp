@@ -0,0 +1,110 @@
+#ifndef PARALLELSEARCH_HPP
+#define PARALLELSEARCH_HPP
+
+#include "SudokuBoard.hpp"
+#include "Trail.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class BTSolver;
+
+/**
+ * Parallel tree search for one board, with work stealing.
+ *
+ * A task is an open subtree: a NetworkState snapshot taken just after
+ * the decisions leading to it, plus its depth. Every worker thread owns
+ * a BTSolver and Trail on the board and a deque of tasks. It pushes and
+ * pops at the back of its own deque, so it goes depth first, while idle
+ * workers steal from the front of others', where the shallowest and
+ * largest subtrees wait.
+ *
+ * Subtrees above splitDepth are split: each consistent child becomes a
+ * task of its own, as long as fewer than SPLIT_LIMIT tasks per thread
+ * are pending. Everything else is searched whole by the worker's
+ * iterative engine. The first solution raises a stop flag that every
+ * solver polls, so all workers wind down within a node.
+ */
+
+struct ParallelResult
+{
+	bool solved = false;
+	bool timedOut = false;
+	SudokuBoard::Board grid;
+
+	long nodes = 0;
+	long tasks = 0;
+	long steals = 0;
+};
+
+class ParallelSearch
+{
+public:
+	// Pending tasks per thread above which no more subtrees are split
+	static const int SPLIT_LIMIT = 4;
+
+	// Constructor
+	ParallelSearch ( const SudokuBoard& board, std::string val_sh, std::string var_sh, std::string cc,
+	                 Trail::Mode trailMode = Trail::DOMAIN_COPY );
+
+	// Modifiers
+	void setFishSize   ( int size );
+	void setSplitDepth ( int depth );
+
+	// Searches with threads workers, allowed budget milliseconds of
+	// wall time (0: BTSolver::DEFAULT_TIME)
+	ParallelResult solve ( int threads, long budget );
+
+private:
+	struct Task
+	{
+		std::vector<unsigned char> state;
+		int depth;
+	};
+
+	// One worker's deque; the owner uses the back, thieves the front
+	struct TaskQueue
+	{
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	// Per-worker counters, merged after the join
+	struct WorkerStats
+	{
+		long nodes = 0;
+		long tasks = 0;
+		long steals = 0;
+		bool timedOut = false;
+	};
+
+	void work   ( int self, bool timed, WorkerStats& stats );
+	bool take   ( int self, Task& task, WorkerStats& stats );
+	void expand ( int self, BTSolver& solver, const Task& task );
+	void claim  ( BTSolver& solver );
+
+	// Setup
+	SudokuBoard board;
+	std::string valHeuristics;
+	std::string varHeuristics;
+	std::string cChecks;
+	Trail::Mode trailMode;
+	int fishSize = 0;
+	int splitDepth = 8;
+
+	// Shared by the workers of one solve()
+	int numThreads = 0;
+	std::vector<std::unique_ptr<TaskQueue>> queues;
+	std::atomic<long> pending;
+	std::atomic<bool> stop;
+	std::atomic<bool> found;
+	std::chrono::steady_clock::time_point deadline;
+	SudokuBoard::Board solution;
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "Pipeline.hpp"
+#include "BoundedQueue.hpp"
+#include "SudokuBoard.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+/**
+ * Parse -> solve -> ordered emit pipeline; see Pipeline.hpp.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+// A parsed board on its way to a solver; index -1 tells a solver to stop
+struct ParsedBoard
+{
+	long index = -1;
+	std::unique_ptr<SudokuBoard> board;
+};
+
+// A solver's result, already formatted, on its way to the writer
+struct SolvedBoard
+{
+	long index = -1;
+	std::string text;
+};
+
+// Busy time and input queue depth of one stage, or of one solver
+class StageMeter
+{
+public:
+	void sample ( std::size_t depth )
+	{
+		maxDepth = std::max( maxDepth, depth );
+		depthSum += depth;
+		samples++;
+	}
+
+	void start ( void )
+	{
+		began = Clock::now();
+	}
+
+	void stop ( void )
+	{
+		busy += Clock::now() - began;
+		items++;
+	}
+
+	void addTo ( StageStats& stats ) const
+	{
+		stats.items += items;
+		stats.busySeconds += std::chrono::duration<double>( busy ).count();
+		stats.maxDepth = std::max( stats.maxDepth, maxDepth );
+		stats.meanDepth += samples ? (double)depthSum / samples : 0.0;
+	}
+
+private:
+	long items = 0;
+	long samples = 0;
+	std::size_t depthSum = 0;
+	std::size_t maxDepth = 0;
+	Clock::duration busy = Clock::duration::zero();
+	Clock::time_point began;
+};
+
+// One solver thread's counts, alone on its cache line
+struct alignas( 64 ) SolverSlot
+{
+	BatchTotals totals;
+	StageMeter meter;
+};
+
+// =====================================================================
+// Constructor
+// =====================================================================
+
+Pipeline::Pipeline ( const BatchSolver& _solver )
+: solver( _solver )
+{
+
+}
+
+// =====================================================================
+// Modifiers
+// =====================================================================
+
+void Pipeline::setQueueCapacity ( std::size_t capacity )
+{
+	queueCapacity = std::max( (std::size_t)2, capacity );
+}
+
+void Pipeline::setFormat ( BoardWriter::Format _format )
+{
+	format = _format;
+}
+
+// Enough to fill both queues and keep every solver busy
+std::size_t Pipeline::window ( int workers ) const
+{
+	return 2 * queueCapacity + std::max( 1, workers );
+}
+
+// =====================================================================
+// Run
+// =====================================================================
+
+PipelineStats Pipeline::run ( const std::vector<std::string>& paths, int workers, std::ostream& out )
+{
+	workers = std::max( 1, workers );
+	long total = paths.size();
+	long limit = window( workers );
+
+	BoundedQueue<ParsedBoard> parsed( queueCapacity );
+	BoundedQueue<SolvedBoard> solved( queueCapacity );
+	std::atomic<long> emitted( 0 );
+
+	StageMeter readMeter;
+	StageMeter writeMeter;
+	std::vector<SolverSlot> slots( workers );
+
+	Clock::time_point start = Clock::now();
+
+	// Parse: never more than limit boards ahead of the writer
+	std::thread reader( [&] ( void )
+	{
+		for ( long i = 0; i < total; ++i )
+		{
+			long ahead;
+			while ( ( ahead = i - emitted.load( std::memory_order_acquire ) ) >= limit )
+				std::this_thread::yield();
+			readMeter.sample( ahead );
+
+			readMeter.start();
+			ParsedBoard item;
+			item.index = i;
+			item.board.reset( new SudokuBoard( paths[i] ) );
+			readMeter.stop();
+
+			parsed.push( std::move( item ) );
+		}
+
+		for ( int w = 0; w < workers; ++w )
+			parsed.push( ParsedBoard() );
+	} );
+
+	// Solve, formatting each result
+	std::vector<std::thread> pool;
+	pool.reserve( workers );
+	for ( int w = 0; w < workers; ++w )
+	{
+		pool.emplace_back( [&, w] ( void )
+		{
+			Trail trail( solver.getTrailMode() );
+			SolverSlot& slot = slots[w];
+			ParsedBoard item;
+
+			while ( true )
+			{
+				slot.meter.sample( parsed.size() );
+				parsed.pop( item );
+				if ( item.index < 0 )
+					break;
+
+				slot.meter.start();
+				SudokuBoard::Board grid;
+				BatchSolver::Outcome outcome = solver.solveBoard( *item.board, trail, slot.totals, &grid );
+				trail.clear();
+
+				SolvedBoard result;
+				result.index = item.index;
+				const std::string& name = paths[item.index];
+				if ( outcome == BatchSolver::SOLVED )
+					BoardWriter::appendBoard( result.text, name, item.board->get_p(), item.board->get_q(), grid, format );
+				else if ( outcome == BatchSolver::TIMED_OUT )
+					BoardWriter::appendFailure( result.text, name, "Timed out", format );
+				else if ( outcome == BatchSolver::MALFORMED )
+					result.text = "[ERROR] " + item.board->getError() + "\n";
+				else
+					BoardWriter::appendFailure( result.text, name, "Failed to find a solution", format );
+				item.board.reset();
+				slot.meter.stop();
+
+				solved.push( std::move( result ) );
+			}
+
+			slot.totals.pushes = trail.getPushCount();
+			slot.totals.stored = trail.getStoredPushCount();
+			slot.totals.backtracks = trail.getUndoCount();
+		} );
+	}
+
+	// Emit in input order. Results in flight all lie within limit of the
+	// next one due, so a ring of limit slots holds them.
+	BoardWriter writer( out, format );
+	std::vector<SolvedBoard> ring( limit );
+	std::vector<char> ready( limit, 0 );
+	long next = 0;
+	while ( next < total )
+	{
+		writeMeter.sample( solved.size() );
+		SolvedBoard result;
+		solved.pop( result );
+
+		writeMeter.start();
+		long at = result.index % limit;
+		ring[at] = std::move( result );
+		ready[at] = 1;
+
+		for ( at = next % limit; next < total && ready[at]; at = next % limit )
+		{
+			writer.writeText( ring[at].text );
+			ring[at].text.clear();
+			ready[at] = 0;
+			emitted.store( ++next, std::memory_order_release );
+		}
+		writeMeter.stop();
+	}
+	writer.flush();
+
+	reader.join();
+	for ( std::thread& t : pool )
+		t.join();
+
+	PipelineStats stats;
+	stats.seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+	readMeter.addTo( stats.parse );
+	writeMeter.addTo( stats.emit );
+
+	for ( const SolverSlot& slot : slots )
+	{
+		slot.meter.addTo( stats.solve );
+		stats.totals.boards += slot.totals.boards;
+		stats.totals.solutions += slot.totals.solutions;
+		stats.totals.timeouts += slot.totals.timeouts;
+		stats.totals.nodes += slot.totals.nodes;
+		stats.totals.pushes += slot.totals.pushes;
+		stats.totals.stored += slot.totals.stored;
+		stats.totals.backtracks += slot.totals.backtracks;
+		stats.totals.malformed += slot.totals.malformed;
+	}
+	stats.solve.meanDepth /= workers;
+	return stats;
+}
@@ -0,0 +1,73 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "BatchSolver.hpp"
+#include "BoardWriter.hpp"
+#include "Trail.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Streaming batch mode: a reader thread parses board files, a pool of
+ * solver threads solves them and a writer thread prints the results in
+ * input order. The stages are joined by two BoundedQueues.
+ *
+ * Memory stays bounded whatever the corpus size. The queues have a
+ * fixed capacity, and the reader never runs more than window() boards
+ * ahead of the writer. That window also sizes the writer's reorder
+ * buffer, so a slow board holds the others back rather than piling
+ * results up.
+ *
+ * Solvers format their results in the BoardWriter format chosen, so the
+ * writer only copies bytes, in large blocks.
+ *
+ * Each stage records the time it spends working (as opposed to waiting
+ * on a queue) and the depth of its input queue, so a run shows which
+ * stage is the bottleneck. The reader has no input queue; its depth is
+ * how far it runs ahead of the writer.
+ */
+
+// Time one stage spent working, and the depth of the queue it reads
+struct StageStats
+{
+	long items = 0;
+	double busySeconds = 0.0;
+	std::size_t maxDepth = 0;
+	double meanDepth = 0.0;
+};
+
+struct PipelineStats
+{
+	BatchTotals totals;
+	StageStats parse;
+	StageStats solve;
+	StageStats emit;
+	double seconds = 0.0;
+};
+
+class Pipeline
+{
+public:
+	// Constructor; boards are solved as solver would solve them
+	explicit Pipeline ( const BatchSolver& solver );
+
+	// Modifiers
+	void setQueueCapacity ( std::size_t capacity );
+	void setFormat        ( BoardWriter::Format format );
+
+	// Boards allowed between the reader and the writer
+	std::size_t window ( int workers ) const;
+
+	// Solves every path on workers solver threads, writing each result
+	// to out in path order
+	PipelineStats run ( const std::vector<std::string>& paths, int workers, std::ostream& out );
+
+private:
+	BatchSolver solver;
+	std::size_t queueCapacity = 64;
+	BoardWriter::Format format = BoardWriter::PRETTY;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "Portfolio.hpp"
+#include "BTSolver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/**
+ * Races BTSolver configurations on separate threads; see Portfolio.hpp.
+ */
+
+// =====================================================================
+// Constructors
+// =====================================================================
+
+Portfolio::Portfolio ( void )
+{
+
+}
+
+Portfolio::Portfolio ( std::vector<PortfolioConfig> _configs, Trail::Mode _trailMode )
+{
+	configs = _configs;
+	trailMode = _trailMode;
+}
+
+std::vector<PortfolioConfig> Portfolio::defaultConfigs ( void )
+{
+	std::vector<PortfolioConfig> defaults( 4 );
+
+	defaults[0].name = "MRV LCV NOR";
+	defaults[0].var_sh = "MinimumRemainingValue";
+	defaults[0].val_sh = "LeastConstrainingValue";
+	defaults[0].cc = "norvigCheck";
+
+	defaults[1].name = "MAD LCV FC";
+	defaults[1].var_sh = "MRVwithTieBreaker";
+	defaults[1].val_sh = "LeastConstrainingValue";
+	defaults[1].cc = "forwardChecking";
+
+	defaults[2].name = "MRV GAC";
+	defaults[2].var_sh = "MinimumRemainingValue";
+	defaults[2].cc = "generalizedArcConsistency";
+
+	defaults[3].name = "TOURN";
+	defaults[3].var_sh = "tournVar";
+	defaults[3].val_sh = "tournVal";
+	defaults[3].cc = "tournCC";
+
+	return defaults;
+}
+
+const std::vector<PortfolioConfig>& Portfolio::getConfigs ( void ) const
+{
+	return configs;
+}
+
+// =====================================================================
+// Solving
+// =====================================================================
+
+PortfolioResult Portfolio::solve ( const SudokuBoard& board, long budget )
+{
+	PortfolioResult result;
+	result.runs.resize( configs.size() );
+
+	std::atomic<bool> stop( false );
+	std::atomic<int> winner( -1 );
+
+	Deadline::Clock::time_point start = Deadline::Clock::now();
+	Deadline::Clock::time_point deadline = start + std::chrono::milliseconds( budget );
+
+	std::vector<std::thread> threads;
+	threads.reserve( configs.size() );
+
+	for ( std::size_t i = 0; i < configs.size(); ++i )
+	{
+		threads.emplace_back( [&, i] ( void )
+		{
+			const PortfolioConfig& config = configs[i];
+			PortfolioRun& run = result.runs[i];
+
+			Trail trail( trailMode );
+			BTSolver solver( board, &trail, config.val_sh, config.var_sh, config.cc );
+			solver.setFishSize( config.fishSize );
+			solver.setCancelFlag( &stop );
+			if ( budget > 0 )
+				solver.setDeadline( deadline );
+
+			solver.run( false );
+
+			if ( solver.haveSolution() )
+				run.status = PortfolioRun::SOLVED;
+			else if ( solver.wasCancelled() )
+				run.status = PortfolioRun::CANCELLED;
+			else if ( solver.timedOut() )
+				run.status = PortfolioRun::TIMED_OUT;
+			else
+				run.status = PortfolioRun::UNSOLVABLE;
+
+			run.nodes = solver.getNodeCount();
+			run.seconds = std::chrono::duration<double>( Deadline::Clock::now() - start ).count();
+
+			// Only a definite answer can win
+			if ( run.status != PortfolioRun::SOLVED && run.status != PortfolioRun::UNSOLVABLE )
+				return;
+
+			int none = -1;
+			if ( winner.compare_exchange_strong( none, (int)i ) )
+			{
+				stop.store( true );
+				if ( run.status == PortfolioRun::SOLVED )
+					result.grid = solver.getSolution().view_board();
+			}
+		} );
+	}
+
+	for ( std::thread& t : threads )
+		t.join();
+
+	result.winner = winner.load();
+	result.solved = result.winner != -1 && result.runs[result.winner].status == PortfolioRun::SOLVED;
+	return result;
+}
@@ -0,0 +1,72 @@
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include "SudokuBoard.hpp"
+#include "Trail.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * Portfolio solving: several BTSolver configurations race on the same
+ * board, one thread each.
+ *
+ * Every thread builds its own Trail and BTSolver (and so its own
+ * network and state); the threads share only the read-only input board,
+ * a cancel flag and the slot for the winner. The first configuration to
+ * reach a definite answer, a solution or a proof that there is none,
+ * claims the slot and raises the flag, and the others give up at their
+ * next node.
+ */
+
+// One solver setup, in the strings BTSolver takes
+struct PortfolioConfig
+{
+	std::string name;
+	std::string var_sh;
+	std::string val_sh;
+	std::string cc;
+	int fishSize = 0;
+};
+
+// How one configuration ended
+struct PortfolioRun
+{
+	enum Status { SOLVED, UNSOLVABLE, TIMED_OUT, CANCELLED };
+
+	Status status = CANCELLED;
+	long nodes = 0;
+	double seconds = 0.0;
+};
+
+struct PortfolioResult
+{
+	// Index of the winning configuration, -1 if none finished in time
+	int winner = -1;
+	bool solved = false;
+	SudokuBoard::Board grid;
+	std::vector<PortfolioRun> runs;
+};
+
+class Portfolio
+{
+public:
+	// Constructors
+	Portfolio ( void );
+	Portfolio ( std::vector<PortfolioConfig> configs, Trail::Mode trailMode = Trail::DOMAIN_COPY );
+
+	// MRV + LCV + NOR, MAD + LCV + FC, MRV + GAC and the tournament setup
+	static std::vector<PortfolioConfig> defaultConfigs ( void );
+
+	// Races every configuration on board, each allowed budget
+	// milliseconds of wall time (0: BTSolver::DEFAULT_TIME)
+	PortfolioResult solve ( const SudokuBoard& board, long budget );
+
+	const std::vector<PortfolioConfig>& getConfigs ( void ) const;
+
+private:
+	std::vector<PortfolioConfig> configs;
+	Trail::Mode trailMode = Trail::DOMAIN_COPY;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "PuzzleFile.hpp"
+#include "BoardParser.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Memory-mapped multi-puzzle files; see PuzzleFile.hpp.
+ */
+
+static bool isSpace ( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Finds the next record at or after cursor, counting lines as it goes
+static bool scanRecord ( const char* data, std::size_t length, std::size_t& cursor, long& line,
+                         PuzzleRecord& record )
+{
+	while ( cursor < length )
+	{
+		const char* begin = data + cursor;
+		const char* end = static_cast<const char*>( memchr( begin, '\n', length - cursor ) );
+		if ( end == nullptr )
+			end = data + length;
+
+		cursor = end - data + 1;
+		++line;
+
+		while ( end > begin && isSpace( end[-1] ) )
+			--end;
+
+		const char* first = begin;
+		while ( first < end && isSpace( *first ) )
+			++first;
+		if ( first == end || *first == '#' )
+			continue;
+
+		record.data = begin;
+		record.length = end - begin;
+		record.line = line;
+		return true;
+	}
+	return false;
+}
+
+// =====================================================================
+// Constructor / Destructor
+// =====================================================================
+
+PuzzleFile::PuzzleFile ( const std::string& filename )
+{
+	int fd = open( filename.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return;
+
+	struct stat info;
+	if ( fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) && info.st_size > 0 )
+	{
+		void* map = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( map != MAP_FAILED )
+		{
+			madvise( map, info.st_size, MADV_SEQUENTIAL );
+			data = static_cast<const char*>( map );
+			length = info.st_size;
+			mapped = true;
+		}
+	}
+
+	// The mapping outlives the descriptor
+	close( fd );
+}
+
+PuzzleFile::~PuzzleFile ( void )
+{
+	if ( mapped )
+		munmap( const_cast<char*>( data ), length );
+}
+
+// =====================================================================
+// Accessors
+// =====================================================================
+
+bool PuzzleFile::isOpen ( void ) const
+{
+	return mapped;
+}
+
+std::size_t PuzzleFile::size ( void ) const
+{
+	return length;
+}
+
+bool PuzzleFile::isLineFormat ( void ) const
+{
+	std::size_t start = 0;
+	long first = 0;
+	PuzzleRecord record;
+	if ( ! scanRecord( data, length, start, first, record ) )
+		return false;
+
+	const char* end = record.data + record.length;
+	const char* token = record.data;
+	while ( isSpace( *token ) )
+		++token;
+	if ( BoardParser::isDotForm( token, end - token ) )
+		return true;
+
+	// A one-board file opens with "p q" alone
+	int tokens = 1;
+	for ( const char* c = token + 1; c < end; ++c )
+		if ( ! isSpace( *c ) && isSpace( c[-1] ) )
+			++tokens;
+	return tokens > 2;
+}
+
+// =====================================================================
+// Reading
+// =====================================================================
+
+bool PuzzleFile::next ( PuzzleRecord& record )
+{
+	return scanRecord( data, length, cursor, line, record );
+}
+
+void PuzzleFile::rewind ( void )
+{
+	cursor = 0;
+	line = 0;
+}
+
+bool PuzzleFile::decode ( const PuzzleRecord& record, int& p, int& q, SudokuBoard::Board& grid,
+                          ParseError& error )
+{
+	BoardParser parser( record.data, record.length, record.line );
+	if ( parser.parse( p, q, grid ) )
+		return true;
+
+	error = parser.getError();
+	return false;
+}
@@ -0,0 +1,74 @@
+#ifndef PUZZLEFILE_HPP
+#define PUZZLEFILE_HPP
+
+#include "BoardParser.hpp"
+#include "SudokuBoard.hpp"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Many puzzles in one file, one puzzle per line, read through mmap.
+ *
+ * A line is either a geometry header followed by the N*N cells in the
+ * usual base-36 odometer tokens:
+ *
+ *     3 3 0 0 3 0 2 0 6 0 0 9 0 0 3 0 5 0 0 1 ...
+ *
+ * or the common 81-character 9x9 form, with '.' or '0' for an empty cell:
+ *
+ *     ..3.2.6..9..3.5..1..18.64....81.29..7.......8..67.82....26.95..8..2.3..9..5.1.3..
+ *
+ * Blank lines and lines starting with '#' are skipped.
+ *
+ * The whole file is mapped once, so reading a million puzzles costs no
+ * per-puzzle system call. next() hands out each line as a PuzzleRecord, a
+ * pointer and length into the mapping; nothing is copied until decode()
+ * runs a BoardParser over it to fill a board.
+ */
+
+// One line of a PuzzleFile, less trailing whitespace; valid while the
+// file is open
+struct PuzzleRecord
+{
+	const char* data = nullptr;
+	std::size_t length = 0;
+	long line = 0;
+};
+
+class PuzzleFile
+{
+public:
+	// Constructor / Destructor
+	explicit PuzzleFile ( const std::string& filename );
+	~PuzzleFile ( void );
+
+	PuzzleFile ( const PuzzleFile& ) = delete;
+	PuzzleFile& operator= ( const PuzzleFile& ) = delete;
+
+	// Accessors
+	bool        isOpen ( void ) const;
+	std::size_t size   ( void ) const;
+
+	// True when the first record is a whole puzzle on one line, rather
+	// than the "p q" header of a one-board file
+	bool isLineFormat ( void ) const;
+
+	// Reads the next record; false at the end of the file
+	bool next ( PuzzleRecord& record );
+	void rewind ( void );
+
+	// Fills p, q and grid from record; false, with error set, when it is
+	// malformed
+	static bool decode ( const PuzzleRecord& record, int& p, int& q, SudokuBoard::Board& grid,
+	                     ParseError& error );
+
+private:
+	const char* data = nullptr;
+	std::size_t length = 0;
+	std::size_t cursor = 0;
+	long line = 0;
+	bool mapped = false;
+};
+
+#endif
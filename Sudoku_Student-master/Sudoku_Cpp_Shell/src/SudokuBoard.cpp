@@ -1,4 +1,6 @@
 #include "SudokuBoard.hpp"
+#include "BoardParser.hpp"
+#include "BoardWriter.hpp"
 
 using namespace std;
 
@@ -61,24 +63,43 @@ SudokuBoard::SudokuBoard ( int _p, int _q, Board _board )
 // Will load a Sudoku board from file
 SudokuBoard::SudokuBoard ( std::string filename )
 {
-	ifstream file( filename );
+	p = 0;
+	q = 0;
 
-	file >> p;
-	file >> q;
-	int N = p*q;
-	string x = "";
-
-	for ( int i = 0; i < N; ++i )
+	ifstream file( filename, ios::binary );
+	if ( ! file )
 	{
-		Row row;
+		error = filename + ": cannot open file";
+		return;
+	}
 
-		for ( int j = 0; j < N; ++j )
-		{
-			file >> x;
-			row.push_back( odometerToInt( x ) );
-		}
+	// One read where the size is known, then one pass over the bytes
+	string buffer;
+	file.seekg( 0, ios::end );
+	streamoff size = file.tellg();
+	if ( size >= 0 )
+	{
+		buffer.resize( size );
+		file.seekg( 0, ios::beg );
+		file.read( &buffer[0], size );
+	}
+	else
+	{
+		// A pipe or other stream that cannot seek: read it in chunks
+		file.clear();
+		char chunk[1 << 14];
+		while ( file.read( chunk, sizeof chunk ) || file.gcount() > 0 )
+			buffer.append( chunk, file.gcount() );
+	}
 
-		board.push_back( row );
+	BoardParser parser( buffer.data(), buffer.size() );
+	if ( ! parser.parse( p, q, board ) )
+	{
+		const ParseError& e = parser.getError();
+		error = filename + ":" + to_string( e.line ) + ":" + to_string( e.column ) + ": " + e.message;
+		p = 0;
+		q = 0;
+		board.clear();
 	}
 }
 
@@ -106,40 +127,30 @@ SudokuBoard::Board SudokuBoard::get_board ( void ) const
 	return board;
 }
 
+const SudokuBoard::Board& SudokuBoard::view_board ( void ) const
+{
+	return board;
+}
+
+bool SudokuBoard::isValid ( void ) const
+{
+	return error.empty();
+}
+
+string SudokuBoard::getError ( void ) const
+{
+	return error;
+}
+
 // =====================================================================
 // String representation
 // =====================================================================
 
 string SudokuBoard::toString ( void ) const
 {
-	stringstream ss;
-	int N = p*q;
-	ss << "P:  " << p << "\t" << "Q:  " << q << "\n";
-
-	for ( int i = 0; i < N; ++i )
-	{
-		for ( int j = 0; j < N; ++j )
-		{
-			ss << intToOdometer( board[i][j] ) << " ";
-
-			if ( (j+1) % q == 0 && j != 0 && j != N-1 )
-			{
-				ss << "| ";
-			}
-		}
-
-		ss << "\n";
-
-		if ( (i+1) % p == 0 && i != 0 && i != N-1 )
-		{
-			for ( int k = 0; k < N+p-1; ++k )
-			{
-				ss << "- ";
-			}
-			ss << "\n";
-		}
-	}
-	return ss.str();
+	string text;
+	BoardWriter::appendPretty( text, p, q, board );
+	return text;
 }
 
 // =====================================================================
@@ -183,36 +194,3 @@ bool SudokuBoard::checkBox ( int row, int col, int value ) const
 
 	return true;
 }
-
-string SudokuBoard::intToOdometer ( int n ) const
-{
-	string ret = "";
-
-	for ( int i = n; n > 0; n /= 36 )
-	{
-		int r  = n % 36;
-		char x = r < 10 ? '0' + r : 'A' + r - 10;
-		ret = x + ret;
-	}
-
-	return ret == "" ? "0" : ret;
-}
-
-int SudokuBoard::odometerToInt ( string str ) const
-{
-	int x = 0;
-
-	if ( str[0] >= '0' && str[0] <= '9' )
-		x = str[0] - '0';
-
-	if ( str[0] >= 'A' && str[0] <= 'Z' )
-		x = str[0] - 'A' + 10;
-
-	for ( int i = 1; i < str.size(); ++i )
-		x *= 36;
-
-	if ( str.size() > 1 )
-		return x + odometerToInt ( str.substr( 1, str.size() - 1 ) );
-
-	return x;
-}
@@ -34,6 +34,15 @@ public:
 	int   get_n     ( void ) const;
 	Board get_board ( void ) const;
 
+	// The board itself, without the copy get_board() makes; valid while
+	// this SudokuBoard lives
+	const Board& view_board ( void ) const;
+
+	// False when the file failed to parse; the board is then 0x0 and
+	// getError() says where and why, as "file:line:column: message"
+	bool        isValid  ( void ) const;
+	std::string getError ( void ) const;
+
 	// String representation
 	std::string toString ( void ) const;
 
@@ -42,15 +51,13 @@ private:
 	int q; // number of columns in a block && number of block rows
 
 	Board board;
+	std::string error;
 
     bool check    ( int row, int col, int value ) const;
 	bool checkRow ( int row, int value ) const;
 	bool checkCol ( int col, int value ) const;
 	bool checkBox ( int row, int col, int value ) const;
 
-	std::string intToOdometer ( int n )      const;
-	int         odometerToInt ( std::string str ) const;
-
 };
 
 #endif
@@ -10,8 +10,15 @@ using namespace std;
 // Constructor
 // =====================================================================
 
-Trail::Trail ( void )
+Trail::Trail ( Mode _mode )
 {
+	mode = _mode;
+
+	if ( mode == DELTA )
+	{
+		deltaStack.reserve( 1 << 14 );
+		deltaMarker.reserve( 1 << 10 );
+	}
 }
 
 // =====================================================================
@@ -20,6 +27,9 @@ Trail::Trail ( void )
 
 int Trail::size ( void )
 {
+	if ( mode == DELTA )
+		return deltaStack.size();
+
 	return trailStack.size();
 }
 
@@ -28,11 +38,32 @@ int Trail::getPushCount ( void )
 	return numPush;
 }
 
+// Pushes that actually saved a record, after skipping repeat saves
+int Trail::getStoredPushCount ( void )
+{
+	return numStored;
+}
+
 int Trail::getUndoCount ( void )
 {
 	return numUndo;
 }
 
+Trail::Mode Trail::getMode ( void )
+{
+	return mode;
+}
+
+long long Trail::getPushBytes ( void )
+{
+	return pushBytes;
+}
+
+long long Trail::getUndoBytes ( void )
+{
+	return undoBytes;
+}
+
 // =====================================================================
 // Modifiers
 // =====================================================================
@@ -40,7 +71,12 @@ int Trail::getUndoCount ( void )
 // Places a marker in the trail
 void Trail::placeTrailMarker ( void )
 {
-	trailMarker.push( trailStack.size() );
+	levels.push_back( ++levelCounter );
+
+	if ( mode == DELTA )
+		deltaMarker.push_back( deltaStack.size() );
+	else
+		trailMarker.push( trailStack.size() );
 }
 
 /**
@@ -53,19 +89,62 @@ void Trail::placeTrailMarker ( void )
 void Trail::push ( Variable* v )
 {
 	numPush++;
+
+	int level = levels.empty() ? baseLevel : levels.back();
+	int id = v->index();
+	if ( id >= (int)stamps.size() )
+		stamps.resize( id + 1, -1 );
+
+	if ( stamps[id] == level )
+		return;
+
+	stamps[id] = level;
+	numStored++;
+
+	if ( mode == DELTA )
+	{
+		const Domain dom = v->getDomain();
+		Delta d;
+		d.var = v;
+		std::copy( dom.bits(), dom.bits() + Domain::WORDS, d.mask );
+		deltaStack.push_back( d );
+		pushBytes += sizeof( Delta );
+		return;
+	}
+
 	trailStack.push( pair<Variable*, Domain>( v, v->getDomain() ) );
+	pushBytes += sizeof( pair<Variable*, Domain> );
 }
 
 // Pops and restores variables on the trail until the last trail marker
 void Trail::undo ( void )
 {
 	numUndo++;
+	levels.pop_back();
+
+	if ( mode == DELTA )
+	{
+		int target = deltaMarker.back();
+		deltaMarker.pop_back();
+		for ( int i = deltaStack.size() - 1; i >= target; --i )
+		{
+			Variable* v = deltaStack[i].var;
+			v->setDomain( Domain( deltaStack[i].mask ) );
+			v->setModified( false );
+			v->unassign();
+		}
+		undoBytes += ( deltaStack.size() - target ) * sizeof( Delta );
+		deltaStack.resize( target );
+		return;
+	}
+
 	int targetSize = trailMarker.top();
 	trailMarker.pop();
 	for ( int size = trailStack.size(); size > targetSize; --size )
 	{
 		pair<Variable*, Domain> vPair = trailStack.top();
 		trailStack.pop();
+		undoBytes += sizeof( pair<Variable*, Domain> );
 		vPair.first->setDomain(vPair.second);
 		vPair.first->setModified( false );
 		vPair.first->unassign();
@@ -80,4 +159,10 @@ void Trail::clear ( void )
 
 	while ( ! trailMarker.empty() )
 		trailMarker.pop();
+
+	deltaStack.clear();
+	deltaMarker.clear();
+
+	levels.clear();
+	baseLevel = ++levelCounter;
 }
@@ -5,24 +5,43 @@
 #include "Variable.hpp"
 
 #include <stack>
+#include <vector>
 #include <utility>
 #include <iostream>
 
 /**
  * Represents the trail of changes made. This allows backtracking to occur.
+ *
+ * Two storage modes are available. DOMAIN_COPY keeps a stack of whole
+ * Domain objects. DELTA keeps (variable, previous mask) records in a
+ * preallocated contiguous buffer, so pushes and undos never allocate.
+ * Both restore the same state.
+ *
+ * Every variable carries a stamp naming the marker level at which it was
+ * last saved. A variable already saved at the current level is not saved
+ * again, since undo only needs its state from the start of the level.
  */
 
 class Trail
 {
 public:
 
+	// Storage modes
+	enum Mode { DOMAIN_COPY, DELTA };
+
 	// Constructor
-	Trail ( void );
+	Trail ( Mode mode = DOMAIN_COPY );
 
 	// Accessors
 	int size ( void );
 	int getPushCount ( void );
+	int getStoredPushCount ( void );
 	int getUndoCount ( void );
+	Mode getMode ( void );
+
+	// Bytes of trail records written by push and replayed by undo
+	long long getPushBytes ( void );
+	long long getUndoBytes ( void );
 
 	// Modifiers
 
@@ -45,12 +64,34 @@ public:
 	void clear ( void );
 
 private:
+	// Record kept by DELTA mode
+	struct Delta
+	{
+		Variable*    var;
+		Domain::Word mask[Domain::WORDS];
+	};
+
 	// Properties
+	Mode mode;
+
 	std::stack<std::pair<Variable*, Domain> > trailStack;
 	std::stack<int> trailMarker;
 
+	std::vector<Delta> deltaStack;
+	std::vector<int> deltaMarker;
+
+	// Save stamps, indexed by variable cell id, and the level ids of
+	// the open markers. Level ids are never reused.
+	std::vector<int> stamps;
+	std::vector<int> levels;
+	int baseLevel = 0;
+	int levelCounter = 0;
+
 	int numPush = 0;
+	int numStored = 0;
 	int numUndo = 0;
+	long long pushBytes = 0;
+	long long undoBytes = 0;
 };
 
 #endif
\ No newline at end of file
@@ -4,39 +4,26 @@
  * Represents a variable in a CSP
  */
 
-int Variable::namingCounter = 1;
-
 // =====================================================================
 // Constructors
 // =====================================================================
 
-Variable::Variable ( Domain::ValueSet possible_Values, int row, int col, int block ) : domain(possible_Values)
+Variable::Variable ( NetworkState* _state, int index, int row, int col, int block )
 {
+	state = _state;
+	idx = index;
 	r = row;
 	c = col;
 	b = block;
-	name = "v" + std::to_string(namingCounter++);
-	oldSize = size();
-	modified = false;
-	changeable = true;
-	assigned = false;
-
-	if ( domain.size() == 1 )
-	{
-		modified = true;
-		changeable = false;
-		assigned = true;
-	}
 }
 
-Variable::Variable ( const Variable& v ) : domain(v.domain)
+Variable::Variable ( const Variable& v )
 {
+	state = v.state;
+	idx = v.index();
 	r = v.row();
 	c = v.col();
 	b = v.block();
-	modified = v.isModified();
-	name = v.getName();
-	changeable = v.isChangeable();
 }
 
 // =====================================================================
@@ -45,17 +32,17 @@ Variable::Variable ( const Variable& v ) : domain(v.domain)
 
 bool Variable::isChangeable( void ) const
 {
-	return changeable;
+	return state->hasFlag( idx, NetworkState::CHANGEABLE );
 }
 
 bool Variable::isAssigned( void ) const
 {
-	return assigned;
+	return state->hasFlag( idx, NetworkState::ASSIGNED );
 }
 
 bool Variable::isModified( void ) const
 {
-	return modified;
+	return state->hasFlag( idx, NetworkState::MODIFIED );
 }
 
 int Variable::row ( void ) const
@@ -75,31 +62,37 @@ int Variable::block ( void ) const
 
 int Variable::size ( void ) const
 {
-	return domain.size();
+	return state->domainSize( idx );
+}
+
+// Returns the cell id of the variable in its NetworkState
+int Variable::index ( void ) const
+{
+	return idx;
 }
 
 // Returns the assigned value or 0 if unassigned
 int Variable::getAssignment ( void ) const
 {
 	if ( isAssigned() )
-		return domain.getValues()[0];
+		return state->value( idx );
 
 	return 0;
 }
 
 Domain Variable::getDomain ( void ) const
 {
-	return domain;
+	return Domain( state->mask( idx ) );
 }
 
 std::string Variable::getName ( void ) const
 {
-	return name;
+	return "v" + std::to_string( idx + 1 );
 }
 
 Domain::ValueSet Variable::getValues ( void ) const
 {
-	return domain.getValues();
+	return getDomain().getValues();
 }
 
 bool Variable::operator== ( const Variable &other ) const
@@ -116,45 +109,60 @@ bool Variable::operator!= ( const Variable &other ) const
 // Modifiers
 // =====================================================================
 
+// Points the handle at another state with the same layout
+void Variable::rebind ( NetworkState* _state )
+{
+	state = _state;
+}
+
 void Variable::unassign()
 {
-	assigned = false;
+	if ( ! isChangeable() )
+		return;
+
+	state->setFlag( idx, NetworkState::ASSIGNED, false );
+	state->setValue( idx, 0 );
 }
 
 void Variable::setModified( bool modified )
 {
-	this->modified = modified;
-	this->domain.setModified(modified);
+	if ( modified )
+		state->markModified( idx );
+	else
+		state->setFlag( idx, NetworkState::MODIFIED, false );
 }
 
 // Assign a value to the variable
 void Variable::assignValue ( int val )
 {
-	if ( ! changeable )
+	if ( ! isChangeable() )
 		return;
 
-	assigned = true;
+	state->setFlag( idx, NetworkState::ASSIGNED, true );
 	setDomain( Domain( val ) );
 }
 
 // Sets the domain of the variable
 void Variable::setDomain ( Domain d )
 {
-	if ( ! changeable )
+	if ( ! isChangeable() )
 		return;
 
-	domain = d;
-	modified = true;
+	state->setMask( idx, d.bits() );
+	state->markModified( idx );
+
+	if ( isAssigned() )
+		state->setValue( idx, d.isEmpty() ? 0 : *d.begin() );
 }
 
 // Removes a value from the domain
 void Variable::removeValueFromDomain ( int val )
 {
-	if ( ! changeable )
+	if ( ! isChangeable() )
 		return;
 
-	domain.remove(val);
-	modified = domain.isModified();
+	if ( state->removeValue( idx, val ) )
+		state->markModified( idx );
 }
 
 // =====================================================================
@@ -163,12 +171,12 @@ void Variable::removeValueFromDomain ( int val )
 
 Domain::iterator Variable::begin()
 {
-	return domain.begin();
+	return Domain::iterator( state->mask( idx ), 0 );
 }
 
 Domain::iterator Variable::end()
 {
-	return domain.end();
+	return Domain::iterator( state->mask( idx ), Domain::WORDS );
 }
 
 // =====================================================================
@@ -179,12 +187,12 @@ std::string Variable::toString()
 {
 	std::stringstream ss;
 	std::string sep = "";
-	ss << " Name: " << name;
+	ss << " Name: " << getName();
 	ss << "\tdomain: {";
 
-	for ( int i = 0; i < domain.getValues().size(); ++i )
+	for ( int value : getDomain() )
 	{
-		ss << sep << domain.getValues()[i];
+		ss << sep << value;
 		sep = ",";
 	}
 
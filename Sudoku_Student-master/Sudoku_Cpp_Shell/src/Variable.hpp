@@ -2,6 +2,7 @@
 #define VARIABLE_HPP
 
 #include "Domain.hpp"
+#include "NetworkState.hpp"
 
 #include <iterator>
 #include <sstream>
@@ -13,6 +14,9 @@
 
 /**
  * Represents a variable in a CSP
+ *
+ * A Variable is a thin handle onto one cell of a NetworkState; the
+ * domain, assignment and flags live in the state's contiguous arrays.
  */
 
 class Variable
@@ -20,7 +24,7 @@ class Variable
 public:
 
 	// Constructors
-	Variable ( Domain::ValueSet possible_Values, int row, int col, int block );
+	Variable ( NetworkState* state, int index, int row, int col, int block );
 	Variable ( const Variable& v );
 
 	// Accessors
@@ -32,6 +36,7 @@ public:
 	int col   ( void ) const;
 	int block ( void ) const;
 	int size  ( void ) const;
+	int index ( void ) const;
 
 	int getAssignment   ( void ) const;
 	Domain getDomain    ( void ) const;
@@ -42,6 +47,7 @@ public:
 	bool operator!= ( const Variable &other ) const;
 
 	// Modifiers
+	void rebind ( NetworkState* state );
 	void unassign ();
 	void setModified ( bool modified );
 	void assignValue ( int val );
@@ -59,14 +65,9 @@ public:
 private:
 
 	// Properties
-	Domain domain;
+	NetworkState* state;
+	int idx;
 	int r, c, b;
-	bool modified;
-	bool changeable;
-	bool assigned;
-	std::string name;
-	int oldSize;
-	static int namingCounter;
 };
 
 #endif